@@ -0,0 +1,260 @@
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <immintrin.h>
+#include <omp.h>
+#include "autotune.h"
+#include "kmp.h"
+#include "task.h"
+
+
+/// Larger than the last level cache, so that reads come from memory.
+constexpr size_t BANDWIDTH_BUFFER_SIZE = 256 * 1024 * 1024;
+/// Small enough to stay in L2.
+constexpr size_t KERNEL_BUFFER_SIZE = 256 * 1024;
+/// Inputs up to this size are assumed to be in cache, so memory bandwidth does not limit them.
+constexpr size_t CACHE_RESIDENT_SIZE = 16 * 1024 * 1024;
+/// Do not give a thread less than this, starting it costs more than scanning.
+constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+/// Stop adding threads once this fraction of the best predicted throughput is reached.
+constexpr double ENOUGH_THROUGHPUT = 0.95;
+/// Prefetching only pays off on some machines, and the differences are small: keep the plain loads unless another
+/// mode is faster by this much.
+constexpr double MODE_MARGIN = 1.05;
+/// Scan modes are measured this many times each, in turns, and the median is kept.
+constexpr int MODE_ROUNDS = 5;
+
+const char *const PROFILE_PATTERN = "PATTERN";
+
+
+/// Read the buffer with *threads* threads, return GB/s.
+static auto read_bandwidth(const uint8_t *p, size_t size, unsigned int threads) -> double {
+    auto tasks = split_tasks(size, 0, threads);
+    auto sums = std::vector<long long>(threads);
+
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto [offset, length] = tasks[index];
+
+        __m256i sum = _mm256_setzero_si256();
+        for (size_t i = 0; i + 32 <= length; i += 32) {
+            sum = _mm256_add_epi64(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + offset + i)));
+        }
+        sums[index] = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 3);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Keep the sums alive, so that the loads are not optimized away.
+    volatile auto sink = std::accumulate(sums.begin(), sums.end(), 0LL);
+    (void) sink;
+    return size / std::chrono::duration<double>(end - start).count() / 1e9;
+}
+
+/// Search the buffer with *threads* threads in *mode*, return GB/s.
+static auto scan_throughput(const char *text, size_t size, unsigned int threads, ScanMode mode) -> double {
+    auto pattern_len = strlen(PROFILE_PATTERN);
+    auto anchors = fixed_anchors(pattern_len);
+    auto tasks = split_tasks(size, pattern_len - 1, threads);
+    auto counts = std::vector<size_t>(threads);
+
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto [offset, length] = tasks[index];
+        counts[index] = simd_search(text + offset, length, PROFILE_PATTERN, pattern_len, anchors, mode).size();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    volatile auto sink = std::accumulate(counts.begin(), counts.end(), size_t{0});
+    (void) sink;
+    return size / std::chrono::duration<double>(end - start).count() / 1e9;
+}
+
+/// Call *search* over *size* bytes repeatedly for a while, return GB/s.
+template<typename F>
+static auto measure_throughput(size_t size, F &&search) -> double {
+    const auto budget = std::chrono::milliseconds(50);
+    size_t calls = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto end = start;
+    do {
+        search();
+        calls++;
+        end = std::chrono::high_resolution_clock::now();
+    } while (end - start < budget);
+
+    return calls * size / std::chrono::duration<double>(end - start).count() / 1e9;
+}
+
+auto measure_profile() -> MachineProfile {
+    MachineProfile profile;
+    profile.hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Bytes which never start a match, so that only the scan is measured.
+    auto buffer = std::vector<uint8_t>(BANDWIDTH_BUFFER_SIZE);
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] = 'a' + i % 23;
+    }
+    auto text = reinterpret_cast<const char *>(buffer.data());
+    auto pattern_len = strlen(PROFILE_PATTERN);
+
+    for (unsigned int threads = 1; threads <= profile.hardware_threads; threads++) {
+        auto best = 0.0;
+        for (auto round = 0; round < 2; round++) {
+            best = std::max(best, read_bandwidth(buffer.data(), buffer.size(), threads));
+        }
+        profile.bandwidth.push_back(best);
+    }
+
+    profile.simd_throughput = measure_throughput(KERNEL_BUFFER_SIZE, [&] {
+        return simd_search(text, KERNEL_BUFFER_SIZE, PROFILE_PATTERN, pattern_len);
+    });
+    profile.kmp_throughput = measure_throughput(KERNEL_BUFFER_SIZE, [&] {
+        return kmp_search(text, KERNEL_BUFFER_SIZE, PROFILE_PATTERN, pattern_len);
+    });
+
+    // Scan modes differ only when the scan is limited by memory, so compare them with as many threads as it takes to
+    // saturate it. A single run is within noise of the others, so take the median of several, measured in turns.
+    auto max_bandwidth = *std::max_element(profile.bandwidth.begin(), profile.bandwidth.end());
+    auto saturating_threads = 1u;
+    while (profile.bandwidth[saturating_threads - 1] < max_bandwidth * ENOUGH_THROUGHPUT) {
+        saturating_threads++;
+    }
+
+    auto modes = {ScanMode::Normal, ScanMode::Prefetch, ScanMode::Stream};
+    std::array<std::vector<double>, 3> rounds;
+    for (auto round = 0; round < MODE_ROUNDS; round++) {
+        for (auto mode: modes) {
+            rounds[static_cast<size_t>(mode)].push_back(
+                    scan_throughput(text, buffer.size(), saturating_threads, mode));
+        }
+    }
+    for (auto mode: modes) {
+        auto &values = rounds[static_cast<size_t>(mode)];
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        profile.mode_throughput[static_cast<size_t>(mode)] = values[values.size() / 2];
+    }
+    return profile;
+}
+
+auto load_profile(const char *path) -> std::optional<MachineProfile> {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    MachineProfile profile;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string key;
+        stream >> key;
+        if (key == "hardware_threads") {
+            stream >> profile.hardware_threads;
+        } else if (key == "bandwidth") {
+            for (double value; stream >> value;) profile.bandwidth.push_back(value);
+        } else if (key == "simd") {
+            stream >> profile.simd_throughput;
+        } else if (key == "kmp") {
+            stream >> profile.kmp_throughput;
+        } else if (key == "modes") {
+            for (auto &value: profile.mode_throughput) stream >> value;
+        }
+        if (stream.bad()) {
+            return std::nullopt;
+        }
+    }
+
+    auto valid = profile.hardware_threads > 0 && profile.bandwidth.size() == profile.hardware_threads
+                 && profile.simd_throughput > 0 && profile.kmp_throughput > 0;
+    return valid ? std::optional(profile) : std::nullopt;
+}
+
+auto save_profile(const char *path, const MachineProfile &profile) -> bool {
+    std::ofstream file(path);
+    file << "hardware_threads " << profile.hardware_threads << "\n";
+    file << "bandwidth";
+    for (auto value: profile.bandwidth) file << " " << value;
+    file << "\n";
+    file << "simd " << profile.simd_throughput << "\n";
+    file << "kmp " << profile.kmp_throughput << "\n";
+    file << "modes";
+    for (auto value: profile.mode_throughput) file << " " << value;
+    file << "\n";
+    return static_cast<bool>(file);
+}
+
+auto load_or_measure_profile(const char *path) -> MachineProfile {
+    auto profile = load_profile(path);
+    if (profile && profile->hardware_threads == std::max(1u, std::thread::hardware_concurrency())) {
+        return *profile;
+    }
+
+    // The profile is only a cache, go on even if it cannot be saved.
+    auto measured = measure_profile();
+    save_profile(path, measured);
+    return measured;
+}
+
+auto tune(const MachineProfile &profile, SearchEngine engine, size_t input_size) -> TuneConfig {
+    TuneConfig config;
+    auto in_cache = input_size <= CACHE_RESIDENT_SIZE;
+
+    // Per-thread throughput. Prefetching only matters for data coming from memory, where it may raise the bandwidth
+    // a scan gets.
+    auto kernel = engine == SearchEngine::SIMD ? profile.simd_throughput : profile.kmp_throughput;
+    auto mode_gain = 1.0;
+    if (engine == SearchEngine::SIMD && !in_cache) {
+        const auto &modes = profile.mode_throughput;
+        auto normal = modes[static_cast<size_t>(ScanMode::Normal)];
+        auto best = std::max_element(modes.begin(), modes.end());
+        if (normal > 0 && *best > normal * MODE_MARGIN) {
+            config.mode = static_cast<ScanMode>(best - modes.begin());
+            mode_gain = *best / normal;
+        }
+    }
+
+    // A thread runs at the kernel speed until the threads together hit the memory bandwidth.
+    auto max_threads = std::clamp<size_t>(input_size / MIN_CHUNK_SIZE, 1, profile.hardware_threads);
+    auto predict = [&](unsigned int threads) {
+        auto compute = threads * kernel;
+        return in_cache ? compute : std::min(compute, profile.bandwidth[threads - 1] * mode_gain);
+    };
+    auto best = 0.0;
+    for (unsigned int threads = 1; threads <= max_threads; threads++) {
+        best = std::max(best, predict(threads));
+    }
+    // Fewer threads leave cores to other work, and cost less to start.
+    config.threads = 1;
+    while (predict(config.threads) < best * ENOUGH_THROUGHPUT) {
+        config.threads++;
+    }
+    config.predicted_throughput = predict(config.threads);
+
+    // A bandwidth-bound scan is even, so one chunk per thread. KMP is slower on some inputs than others, so give it
+    // smaller chunks to balance dynamically.
+    auto chunks = config.threads * (engine == SearchEngine::KMP ? 4 : 1);
+    auto chunk_size = (input_size + chunks - 1) / chunks;
+    config.chunk_size = std::max(MIN_CHUNK_SIZE, (chunk_size + 4095) / 4096 * 4096);
+    return config;
+}
+
+auto display_scan_mode(ScanMode mode) -> std::string {
+    switch (mode) {
+        case ScanMode::Normal:
+            return "normal";
+        case ScanMode::Prefetch:
+            return "prefetch";
+        case ScanMode::Stream:
+            return "stream";
+    }
+    return "unknown";
+}
@@ -0,0 +1,50 @@
+#ifndef PARALLEL_AUTOTUNE_H
+#define PARALLEL_AUTOTUNE_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstddef>
+#include "simd_search.h"
+#include "search_control.h"
+
+/// What the machine can do, measured once and cached in a profile file.
+struct MachineProfile {
+    unsigned int hardware_threads = 1;
+    /// Sustainable read bandwidth from memory in GB/s, with 1, 2, ..., hardware_threads threads.
+    std::vector<double> bandwidth;
+    /// Single-thread throughput on data in cache, in GB/s.
+    double simd_throughput = 0;
+    double kmp_throughput = 0;
+    /// Throughput of the SIMD kernel on data in memory, with enough threads to saturate the bandwidth, in GB/s,
+    /// indexed by ScanMode.
+    std::array<double, 3> mode_throughput{};
+};
+
+/// How to run a search.
+struct TuneConfig {
+    unsigned int threads = 1;
+    /// Bytes per task. There may be more tasks than threads, they are then scheduled dynamically.
+    size_t chunk_size = 0;
+    ScanMode mode = ScanMode::Normal;
+    /// Expected throughput in GB/s.
+    double predicted_throughput = 0;
+};
+
+/// Run the micro benchmarks. It takes about a second.
+auto measure_profile() -> MachineProfile;
+
+auto load_profile(const char *path) -> std::optional<MachineProfile>;
+
+auto save_profile(const char *path, const MachineProfile &profile) -> bool;
+
+/// Load the profile cached in *path*, or measure and save one if it is missing or from another machine.
+auto load_or_measure_profile(const char *path) -> MachineProfile;
+
+/// Pick the thread count, chunk size and scan mode for searching *input_size* bytes with *engine*.
+auto tune(const MachineProfile &profile, SearchEngine engine, size_t input_size) -> TuneConfig;
+
+auto display_scan_mode(ScanMode mode) -> std::string;
+
+#endif //PARALLEL_AUTOTUNE_H
@@ -7,7 +7,9 @@
 
 
 #include <stdexcept>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cerrno>
 #include <cstring>
 #include <sys/mman.h>
@@ -21,10 +23,17 @@ private:
     /// File descriptor.
     int fd = 0;
 
-    /// Start address of file content loaded in memory.
+    /// Start address of the mapping, which is aligned to the page size.
+    void *map_start = nullptr;
+    /// Length of the mapping.
+    size_t map_size = 0;
+
+    /// Start address of the requested range loaded in memory.
     uint8_t *start = nullptr;
-    /// File size.
+    /// Size of the requested range.
     size_t size = 0;
+    /// Size of the whole file.
+    size_t file_size = 0;
 
     /// Raw file name.
     const char *filename = nullptr;
@@ -42,10 +51,24 @@ public:
         return size;
     }
 
+    size_t get_file_size() const {
+        return file_size;
+    }
+
+    /// Map the whole file.
     void load() {
+        load(0, SIZE_MAX);
+    }
+
+    /// Map [offset, offset + length) of the file. The range is clamped to the end of the file.
+    void load(size_t offset, size_t length) {
+        close();
+
         // Open file and get file descriptor.
         this->fd = open(this->filename, O_RDONLY);
         if (this->fd == -1) {
+            this->fd = 0;
+
             auto error_message = strerror(errno);
             auto message = "failed to open file " + std::string(this->filename) + ": " + error_message;
             throw Exception(message);
@@ -62,33 +85,49 @@ public:
             auto message = "failed to get file stat of " + std::string(this->filename) + ": " + error_message;
             throw Exception(message);
         }
-        this->size = file_stat.st_size;
+        this->file_size = file_stat.st_size;
+        offset = std::min(offset, this->file_size);
+        this->size = std::min(length, this->file_size - offset);
 
-        // Map file content to memory.
-        auto addr = mmap(nullptr, 0, PROT_READ, MAP_PRIVATE, fd, 0);
-        this->start = reinterpret_cast<uint8_t *>(addr);
-        if (this->start == MAP_FAILED) {
+        // mmap does not accept an empty mapping.
+        if (this->size == 0) {
+            return;
+        }
+
+        // Map file content to memory. The offset passed to mmap must be a multiple of the page size.
+        auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto map_offset = offset / page_size * page_size;
+        this->map_size = this->size + (offset - map_offset);
+        auto addr = mmap(nullptr, this->map_size, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(map_offset));
+        if (addr == MAP_FAILED) {
             // Close file descriptor, clean the environment.
             ::close(this->fd);
-            this->start = nullptr;
+            this->fd = 0;
+            this->map_size = 0;
             this->size = 0;
 
             auto error_message = strerror(errno);
             auto message = "failed to map file " + std::string(this->filename) + ": " + error_message;
             throw Exception(message);
         }
-
+        this->map_start = addr;
+        this->start = reinterpret_cast<uint8_t *>(addr) + (offset - map_offset);
     }
 
     void close() {
-        if (nullptr != this->start) {
-            munmap(this->start, 0);
-            ::close(this->fd);
+        if (nullptr != this->map_start) {
+            munmap(this->map_start, this->map_size);
 
-            this->start = nullptr;
+            this->map_start = nullptr;
+            this->map_size = 0;
+        }
+        if (0 != this->fd) {
+            ::close(this->fd);
             this->fd = 0;
-            this->size = 0;
         }
+
+        this->start = nullptr;
+        this->size = 0;
     }
 };
 
@@ -5,6 +5,9 @@
 #ifndef PARALLEL_KMP_H
 #define PARALLEL_KMP_H
 
+#include <vector>
+#include <cstddef>
+
 auto kmp_search(const char *text, const size_t text_len, const char *pattern,
                 const size_t pattern_len) -> std::vector<size_t>;
 
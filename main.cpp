@@ -7,22 +7,20 @@
 #include <chrono>
 #include <iostream>
 #include <algorithm>
+#include <random>
 #include <omp.h>
 #include "kmp.h"
 #include "simd_search.h"
 #include "util.h"
 #include "file_mapper.h"
 #include "memory.h"
-
-
-struct Task {
-    size_t offset;
-    size_t size;
-
-    Task() = default;
-
-    Task(size_t offset, size_t size) : offset(offset), size(size) {}
-};
+#include "task.h"
+#include "openmp_search.h"
+#include "match_list.h"
+#include "search_control.h"
+#include "regex_search.h"
+#include "record_search.h"
+#include "autotune.h"
 
 
 auto search_with_single_thread(const uint8_t *p, size_t total_length, const char *pattern)
@@ -47,27 +45,26 @@ auto search_with_single_thread_simd(const uint8_t *p, size_t total_length, const
     return {result, duration};
 }
 
+auto search_with_single_thread_simd_anchors(const uint8_t *p, size_t total_length, const char *pattern,
+                                            const SimdAnchors &anchors)
+-> std::pair<std::vector<size_t>, long> {
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto result = simd_search(reinterpret_cast<const char *>(p), total_length, pattern, strlen(pattern), anchors);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    return {result, duration};
+}
+
 
 auto search_with_openmp(const uint8_t *p, size_t total_length, const char *pattern, const unsigned int threads)
 -> std::pair<std::vector<size_t>, long> {
 
-    auto task_size = total_length / threads;
-    std::vector<Task> tasks(threads);
-
-    // Generate tasks.
-    // Assume that total size is 395, we split it into 4 tasks. And the length to the pattern is 5.
-    //  |__100__|__100__|__100__|__95__|
-    // tasks are: [0, 100), [96, 200), [196, 300), [296, 395]
+    // Generate tasks, each of them overlaps the next one by `pattern_len - 1` bytes.
     auto base_addr = p;
-    auto file_len = total_length;
     auto pattern_len = strlen(pattern);
-    std::generate(tasks.begin(), tasks.end(), [&, i = 0]() mutable {
-        auto start = i == 0 ? 0 : (i * task_size - (pattern_len - 1));
-        auto real_size = i == threads - 1 ? std::min(task_size, file_len - i * task_size) : task_size;
-        real_size += pattern_len;
-        i++;
-        return Task(start, real_size);
-    });
+    auto tasks = split_tasks(total_length, pattern_len - 1, threads);
 
     auto mid_result = std::vector<std::vector<size_t>>(threads);
     auto start = std::chrono::high_resolution_clock::now();
@@ -99,39 +96,25 @@ auto search_with_openmp(const uint8_t *p, size_t total_length, const char *patte
     return {result, duration};
 }
 
-auto search_with_openmp_simd(const uint8_t *p, size_t total_length, const char *pattern, const unsigned int threads)
+/// Like search_with_openmp_simd, with the thread count, chunk size and scan mode picked by the autotuner.
+auto search_with_openmp_simd_tuned(const uint8_t *p, size_t total_length, const char *pattern,
+                                   const TuneConfig &config)
 -> std::pair<std::vector<size_t>, long> {
 
-    auto task_size = total_length / threads;
-    std::vector<Task> tasks(threads);
-
-    // Generate tasks.
-    // Assume that total size is 395, we split it into 4 tasks. And the length to the pattern is 5.
-    //  |__100__|__100__|__100__|__95__|
-    // tasks are: [0, 100), [96, 200), [196, 300), [296, 395]
     auto base_addr = p;
-    auto file_len = total_length;
     auto pattern_len = strlen(pattern);
-    std::generate(tasks.begin(), tasks.end(), [&, i = 0]() mutable {
-        auto start = i == 0 ? 0 : (i * task_size - (pattern_len - 1));
-        auto real_size = i == threads - 1 ? std::min(task_size, file_len - i * task_size) : task_size;
-        real_size += pattern_len;
-        i++;
-        return Task(start, real_size);
-    });
+    auto task_count = std::max<size_t>(1, (total_length + config.chunk_size - 1) / config.chunk_size);
+    auto tasks = split_tasks(total_length, pattern_len - 1, task_count);
+    auto anchors = fixed_anchors(pattern_len);
 
-    auto mid_result = std::vector<std::vector<size_t>>(threads);
+    auto mid_result = std::vector<std::vector<size_t>>(task_count);
     auto start = std::chrono::high_resolution_clock::now();
-    // Assign tasks to threads.
-#pragma omp parallel num_threads(threads)
-    {
-        auto index = omp_get_thread_num();
-        auto task = tasks[index];
-
-        auto [_offset, _size] = task;
-        auto result = simd_search(reinterpret_cast<const char *>(base_addr + _offset), _size, pattern, strlen(pattern));
-
-        // kmp_search only returns the offset to the pattern from the start of the block, not the base address.
+    // There may be more tasks than threads, hand them out as threads get free.
+#pragma omp parallel for num_threads(config.threads) schedule(dynamic, 1)
+    for (size_t index = 0; index < task_count; index++) {
+        auto [_offset, _size] = tasks[index];
+        auto result = simd_search(reinterpret_cast<const char *>(base_addr + _offset), _size, pattern, pattern_len,
+                                  anchors, config.mode);
         for (auto &r: result) {
             r += _offset;
         }
@@ -149,6 +132,124 @@ auto search_with_openmp_simd(const uint8_t *p, size_t total_length, const char *
     return {result, duration};
 }
 
+/// Like search_with_openmp_simd, but gives up after *timeout*, and returns the matches in the ranges covered by then.
+auto search_with_openmp_simd_deadline(const uint8_t *p, size_t total_length, const char *pattern,
+                                      const unsigned int threads, std::chrono::microseconds timeout)
+-> std::pair<PartialResult, long> {
+
+    SearchControl control(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+    control.set_timeout(timeout);
+    auto result = search_cancellable(p, total_length, pattern, threads, control);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    return {std::move(result), duration};
+}
+
+/// Find matches of a regex with the same task split as search_with_openmp_simd. The overlap between tasks covers the
+/// longest possible match, or the rest of the input if the length of matches is not bounded. Matches crossing a task
+/// boundary are resolved by regex_join.
+auto search_with_openmp_regex(const uint8_t *p, size_t total_length, const Regex &regex, const unsigned int threads)
+-> std::pair<std::vector<RegexMatch>, long> {
+
+    auto base_addr = reinterpret_cast<const char *>(p);
+    auto tasks = split_tasks(total_length, regex_overlap(regex, total_length), threads);
+
+    auto mid_result = std::vector<std::vector<RegexMatch>>(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto [_offset, _size] = tasks[index];
+        auto owned = (index + 1 < threads ? tasks[index + 1].offset : total_length) - _offset;
+
+        auto result = regex_search(regex, base_addr + _offset, _size, owned);
+        for (auto &r: result) {
+            r.start += _offset;
+            r.end += _offset;
+        }
+        mid_result[index] = std::move(result);
+    }
+    auto result = regex_join(regex, base_addr, total_length, tasks, std::move(mid_result));
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    return {std::move(result), duration};
+}
+
+/// Like search_with_openmp_simd, but each thread encodes its matches as varint deltas, and the lists are
+/// concatenated without copying the matches again.
+auto search_with_openmp_simd_varint(const uint8_t *p, size_t total_length, const char *pattern,
+                                    const unsigned int threads)
+-> std::pair<VarintMatchList, long> {
+
+    auto base_addr = p;
+    auto pattern_len = strlen(pattern);
+    auto tasks = split_tasks(total_length, pattern_len - 1, threads);
+    auto anchors = fixed_anchors(pattern_len);
+
+    auto mid_result = std::vector<VarintMatchList>(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto [_offset, _size] = tasks[index];
+
+        auto result = VarintMatchList(_offset);
+        simd_search(reinterpret_cast<const char *>(base_addr + _offset), _size, pattern, pattern_len, anchors,
+                    _offset, result);
+        mid_result[index] = std::move(result);
+    }
+
+    auto result = VarintMatchList();
+    for (auto &r: mid_result) {
+        result.append(std::move(r));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    return {std::move(result), duration};
+}
+
+/// Like search_with_openmp_simd_varint, but matches are marked in a bitmap, one bit per position.
+auto search_with_openmp_simd_bitmap(const uint8_t *p, size_t total_length, const char *pattern,
+                                    const unsigned int threads)
+-> std::pair<MatchBitmap, long> {
+
+    auto base_addr = p;
+    auto pattern_len = strlen(pattern);
+    auto tasks = split_tasks(total_length, pattern_len - 1, threads);
+    auto anchors = fixed_anchors(pattern_len);
+
+    auto mid_result = std::vector<MatchBitmap>(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto [_offset, _size] = tasks[index];
+
+        // A task only holds the matches starting before the overlapped tail.
+        auto covered = _size >= pattern_len ? _size - pattern_len + 1 : 0;
+        auto result = MatchBitmap(_offset, covered);
+        simd_search(reinterpret_cast<const char *>(base_addr + _offset), _size, pattern, pattern_len, anchors,
+                    _offset, result);
+        mid_result[index] = std::move(result);
+    }
+
+    auto result = MatchBitmap();
+    for (auto &r: mid_result) {
+        result.append(std::move(r));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    return {std::move(result), duration};
+}
+
 auto check_print_result(const uint8_t *text, size_t text_len, const char *pattern, const std::vector<size_t> &result,
                         const size_t expected_result_count) {
     auto checker = check_result_quickly(text, text_len, pattern, result);
@@ -201,12 +302,118 @@ do_parallel_test_in_memory(const uint8_t *p, const size_t size, const char *patt
     return {duration3, duration4};
 }
 
+/// Compare fixed first/last anchoring with anchors chosen by the text profile and by a sampled histogram.
+auto
+do_anchor_test_in_memory(const uint8_t *p, const size_t size, const char *pattern, const size_t expected_result_count)
+-> std::vector<long> {
+    auto text = reinterpret_cast<const char *>(p);
+    auto pattern_len = strlen(pattern);
+    const SimdAnchors anchors[] = {
+            fixed_anchors(pattern_len),
+            select_anchors(pattern, pattern_len, text_byte_frequency()),
+            select_anchors(pattern, pattern_len, sample_byte_frequency(text, size)),
+    };
+
+    std::vector<long> durations;
+    for (const auto &anchor: anchors) {
+        auto [result, duration] = search_with_single_thread_simd_anchors(p, size, pattern, anchor);
+        if (!check_print_result(p, size, pattern, result, expected_result_count)) {
+            std::cerr << "anchored SIMD test failed." << std::endl;
+        }
+        durations.push_back(duration);
+    }
+    return durations;
+}
+
+/// Compare the plain vector with the compact match lists on dense matches. The merge step is included.
+auto do_density_test_in_memory(const uint8_t *p, const size_t size, const char *pattern, const unsigned int threads)
+-> std::vector<std::pair<long, size_t>> {
+    auto timed = [](auto &&search) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto result = search();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::pair{std::move(result), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()};
+    };
+
+    auto [result1, duration1] = timed([&] { return search_with_openmp_simd(p, size, pattern, threads).first; });
+    auto [result2, duration2] = timed([&] { return search_with_openmp_simd_varint(p, size, pattern, threads).first; });
+    auto [result3, duration3] = timed([&] { return search_with_openmp_simd_bitmap(p, size, pattern, threads).first; });
+
+    // 用单线程 KMP 的结果作为独立的参照，检查是否有匹配在任务边界处遗漏或重复
+    auto expected = search_with_single_thread(p, size, pattern).first;
+    if (!check_print_result(p, size, pattern, result1, expected.size()) || result1 != expected) {
+        std::cerr << "dense parallel SIMD test failed." << std::endl;
+    }
+    if (!std::equal(result1.begin(), result1.end(), result2.begin(), result2.end())) {
+        std::cerr << "varint match list differs from the plain result." << std::endl;
+    }
+    if (!std::equal(result1.begin(), result1.end(), result3.begin(), result3.end())) {
+        std::cerr << "match bitmap differs from the plain result." << std::endl;
+    }
+
+    return {{duration1, result1.size() * sizeof(size_t)},
+            {duration2, result2.encoded_size()},
+            {duration3, result3.encoded_size()}};
+}
+
+/// Cut the memory into short records (20 ~ 200 bytes, separated by one byte), and compare one `simd_search` per
+/// record, the batched search, and a single search over the whole buffer.
+auto do_record_test_in_memory(const uint8_t *p, const size_t size, const char *pattern)
+-> std::vector<long> {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> dis(20, 200);
+    std::vector<size_t> offsets, lengths;
+    for (size_t offset = 0, length = dis(gen); offset + length <= size; offset += length + 1, length = dis(gen)) {
+        offsets.push_back(offset);
+        lengths.push_back(length);
+    }
+
+    auto text = reinterpret_cast<const char *>(p);
+    auto pattern_len = strlen(pattern);
+    auto timed = [](auto &&search) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto result = search();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::pair{std::move(result), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()};
+    };
+
+    auto [result1, duration1] = timed([&] {
+        std::vector<RecordMatch> result;
+        for (size_t i = 0; i < offsets.size(); i++) {
+            for (auto offset: simd_search(text + offsets[i], lengths[i], pattern, pattern_len)) {
+                result.push_back({i, offset});
+            }
+        }
+        return result;
+    });
+    auto [result2, duration2] = timed([&] {
+        return search_records(text, offsets.data(), lengths.data(), offsets.size(), pattern, pattern_len);
+    });
+    auto [result3, duration3] = timed([&] {
+        return search_records(text, offsets.data(), lengths.data(), offsets.size(), pattern, pattern_len, 4);
+    });
+    auto [result4, duration4] = timed([&] { return simd_search(text, size, pattern, pattern_len); });
+
+    if (result1 != result2 || result1 != result3) {
+        std::cerr << "batched record search test failed." << std::endl;
+    }
+    return {duration1, duration2, duration3, duration4};
+}
+
 
 int main() {
     const auto MIN_MEMORY_USE = 128 * 1024 * 1024L;
     const auto MAX_MEMORY_USE = 8 * 1024 * 1024 * 1024L;
     const auto PATTERN = "PATTERN";
     const auto PATTERN_COUNT = 5;
+    const auto PROFILE_PATH = "parallel_profile.txt";
+
+    // 测量（或从缓存文件读取）内存带宽与各算法的单线程吞吐量，用于选择线程数等参数
+    auto profile = load_or_measure_profile(PROFILE_PATH);
+    std::cout << std::format("memory bandwidth: {:.1f} GB/s (1 thread) ~ {:.1f} GB/s ({} threads), "
+                             "SIMD {:.1f} GB/s, KMP {:.2f} GB/s per thread",
+                             profile.bandwidth.front(), profile.bandwidth.back(), profile.hardware_threads,
+                             profile.simd_throughput, profile.kmp_throughput) << std::endl;
 
     // 一次分配，多次使用，提高测试性能.
     auto p = new uint8_t[MAX_MEMORY_USE];
@@ -233,6 +440,86 @@ int main() {
             }
             std::cout << std::endl;
         }
+
+        // 自动选择的配置，并比较预测与实际的吞吐量
+        auto config = tune(profile, SearchEngine::SIMD, size);
+        auto [tuned_result, tuned_duration] = search_with_openmp_simd_tuned(p, size, PATTERN, config);
+        if (!check_print_result(p, size, PATTERN, tuned_result, PATTERN_COUNT)) {
+            std::cerr << "tuned parallel SIMD test failed." << std::endl;
+        }
+        std::cout << std::format("auto c{} chunk {} {}: {} ({:.0f}%), predicted {:.1f} GB/s, achieved {:.1f} GB/s",
+                                 config.threads, display_size(config.chunk_size), display_scan_mode(config.mode),
+                                 display_time(tuned_duration), durations[0] * 100. / tuned_duration,
+                                 config.predicted_throughput, size / (tuned_duration * 1e3)) << std::endl;
+
+        // 限时查找：只给串行 SIMD 一半的时间，输出截止前覆盖的数据比例
+        auto timeout = std::chrono::microseconds(durations[1] / 2);
+        auto [partial, duration] = search_with_openmp_simd_deadline(p, size, PATTERN, 4, timeout);
+        auto covered = 0UL;
+        for (auto [begin, end]: partial.covered) {
+            covered += end - begin;
+        }
+        std::cout << std::format("c4 deadline {}: covered {:.0f}% ({} matches) in {}", display_time(timeout.count()),
+                                 covered * 100. / size, partial.matches.size(), display_time(duration)) << std::endl;
+    }
+
+    // 在类文本数据上比较 SIMD 锚点的选择策略：固定首尾、内置文本分布、采样直方图
+    const auto MAX_ANCHOR_TEST_MEMORY_USE = 1024 * 1024 * 1024L;
+    const auto TEXT_PATTERN = " jukebox ";
+    for (auto size = MIN_MEMORY_USE; size <= MAX_ANCHOR_TEST_MEMORY_USE; size *= 2) {
+        generate_text_test_data(p, size, TEXT_PATTERN, PATTERN_COUNT);
+        auto durations = do_anchor_test_in_memory(p, size, TEXT_PATTERN, PATTERN_COUNT);
+
+        std::cout << "text size: " << display_size(size) << ", fixed & profile & sampled anchors cost: ";
+        for (auto duration: durations) {
+            std::cout << std::format("{} ({:.0f}%) ", display_time(duration), durations[0] * 100. / duration);
+        }
+        std::cout << std::endl;
+    }
+
+    // 大量短记录的批量查找：逐条查找、批量查找（单线程、4 线程）、整块查找
+    const auto MAX_RECORD_TEST_MEMORY_USE = 512 * 1024 * 1024L;
+    for (auto size = MIN_MEMORY_USE; size <= MAX_RECORD_TEST_MEMORY_USE; size *= 2) {
+        generate_text_test_data(p, size, TEXT_PATTERN, PATTERN_COUNT);
+        auto durations = do_record_test_in_memory(p, size, TEXT_PATTERN);
+
+        std::cout << "records size: " << display_size(size) << ", per record & batched & batched c4 & whole buffer: ";
+        for (auto duration: durations) {
+            std::cout << std::format("{} ({:.0f}%) ", display_time(duration), durations[0] * 100. / duration);
+        }
+        std::cout << std::endl;
+    }
+
+    // 正则表达式查找：在类文本数据中放置日志行，比较单线程和多线程的用时
+    const auto MAX_REGEX_TEST_MEMORY_USE = 1024 * 1024 * 1024L;
+    const auto LOG_LINE = "ERROR 4096 timeout";
+    const Regex LOG_REGEX("ERROR [0-9]+ timeout");
+    for (auto size = MIN_MEMORY_USE; size <= MAX_REGEX_TEST_MEMORY_USE; size *= 2) {
+        generate_text_test_data(p, size, LOG_LINE, PATTERN_COUNT);
+
+        std::cout << "text size: " << display_size(size) << ", regex costs: ";
+        for (auto threads: {1u, 4u}) {
+            auto [result, duration] = search_with_openmp_regex(p, size, LOG_REGEX, threads);
+            if (result.size() != PATTERN_COUNT) {
+                std::cerr << "incorrect count of regex matches:" << result.size() << std::endl;
+            }
+            std::cout << std::format("c{} {} ", threads, display_time(duration));
+        }
+        std::cout << std::endl;
+    }
+
+    // 在高密度匹配（DNA 数据中的短模式串）下比较结果的表示方式：std::vector、varint 差分编码、位图
+    const auto MAX_DENSITY_TEST_MEMORY_USE = 512 * 1024 * 1024L;
+    const auto DNA_PATTERN = "AA";
+    for (auto size = MIN_MEMORY_USE; size <= MAX_DENSITY_TEST_MEMORY_USE; size *= 2) {
+        generate_dna_test_data(p, size);
+        auto results = do_density_test_in_memory(p, size, DNA_PATTERN, 4);
+
+        std::cout << "dna size: " << display_size(size) << ", vector & varint & bitmap costs: ";
+        for (auto [duration, bytes]: results) {
+            std::cout << std::format("{} / {} ", display_time(duration), display_size(bytes));
+        }
+        std::cout << std::endl;
     }
 
     delete[] p;
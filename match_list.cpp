@@ -0,0 +1,180 @@
+#include <cassert>
+#include <numeric>
+#include "match_list.h"
+
+
+VarintMatchList::VarintMatchList(size_t base) : last(base) {
+    segments.push_back(Segment{base, 0, {}});
+}
+
+auto VarintMatchList::push_back(size_t offset) -> void {
+    assert(offset >= last);
+
+    auto &segment = segments.back();
+    auto delta = offset - last;
+    // 每个字节保存 7 bit，最高位表示后面还有字节
+    while (delta >= 0x80) {
+        segment.bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    segment.bytes.push_back(static_cast<uint8_t>(delta));
+
+    segment.count++;
+    count++;
+    last = offset;
+}
+
+auto VarintMatchList::append(VarintMatchList &&other) -> void {
+    for (auto &segment: other.segments) {
+        if (segment.count == 0) continue;
+
+        assert(segment.base >= last);
+        segments.push_back(std::move(segment));
+    }
+    if (other.count != 0) {
+        last = other.last;
+        count += other.count;
+    }
+
+    other.segments.clear();
+    other.count = 0;
+}
+
+auto VarintMatchList::encoded_size() const -> size_t {
+    return std::accumulate(segments.begin(), segments.end(), size_t(0), [](size_t sum, const Segment &segment) {
+        return sum + segment.bytes.size();
+    });
+}
+
+auto VarintMatchList::begin() const -> Iterator {
+    return {&segments, 0};
+}
+
+auto VarintMatchList::end() const -> Iterator {
+    return {&segments, segments.size()};
+}
+
+auto VarintMatchList::to_vector() const -> std::vector<size_t> {
+    std::vector<size_t> result;
+    result.reserve(count);
+    result.insert(result.end(), begin(), end());
+    return result;
+}
+
+VarintMatchList::Iterator::Iterator(const std::vector<Segment> *segments, size_t segment)
+        : segments(segments), segment(segment) {
+    while (this->segment < segments->size() && (*segments)[this->segment].count == 0) {
+        this->segment++;
+    }
+    if (this->segment < segments->size()) {
+        value = (*segments)[this->segment].base;
+        decode();
+    }
+}
+
+auto VarintMatchList::Iterator::decode() -> void {
+    const auto &bytes = (*segments)[segment].bytes;
+
+    size_t delta = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = bytes[position++];
+        delta |= static_cast<size_t>(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    value += delta;
+}
+
+auto VarintMatchList::Iterator::operator++() -> Iterator & {
+    if (position < (*segments)[segment].bytes.size()) {
+        decode();
+        return *this;
+    }
+
+    *this = Iterator(segments, segment + 1);
+    return *this;
+}
+
+
+MatchBitmap::MatchBitmap(size_t base, size_t length) {
+    segments.push_back(Segment{base, length, std::vector<uint64_t>((length + 63) / 64)});
+}
+
+auto MatchBitmap::push_back(size_t offset) -> void {
+    auto &segment = segments.back();
+    assert(offset >= segment.base && offset < segment.base + segment.length);
+
+    auto index = offset - segment.base;
+    segment.words[index / 64] |= uint64_t(1) << (index % 64);
+    count++;
+}
+
+auto MatchBitmap::append(MatchBitmap &&other) -> void {
+    for (auto &segment: other.segments) {
+        if (segment.length == 0) continue;
+
+        assert(segments.empty() || segment.base >= segments.back().base + segments.back().length);
+        segments.push_back(std::move(segment));
+    }
+    count += other.count;
+
+    other.segments.clear();
+    other.count = 0;
+}
+
+auto MatchBitmap::encoded_size() const -> size_t {
+    return std::accumulate(segments.begin(), segments.end(), size_t(0), [](size_t sum, const Segment &segment) {
+        return sum + segment.words.size() * sizeof(uint64_t);
+    });
+}
+
+auto MatchBitmap::begin() const -> Iterator {
+    return {&segments, 0};
+}
+
+auto MatchBitmap::end() const -> Iterator {
+    return {&segments, segments.size()};
+}
+
+auto MatchBitmap::to_vector() const -> std::vector<size_t> {
+    std::vector<size_t> result;
+    result.reserve(count);
+    result.insert(result.end(), begin(), end());
+    return result;
+}
+
+MatchBitmap::Iterator::Iterator(const std::vector<Segment> *segments, size_t segment)
+        : segments(segments), segment(segment) {
+    if (segment < segments->size() && !(*segments)[segment].words.empty()) {
+        bits = (*segments)[segment].words[0];
+    }
+    skip_empty();
+}
+
+auto MatchBitmap::Iterator::skip_empty() -> void {
+    while (bits == 0 && segment < segments->size()) {
+        const auto &words = (*segments)[segment].words;
+        if (word + 1 < words.size()) {
+            bits = words[++word];
+            continue;
+        }
+
+        segment++;
+        word = 0;
+        if (segment < segments->size() && !(*segments)[segment].words.empty()) {
+            bits = (*segments)[segment].words[0];
+        }
+    }
+}
+
+auto MatchBitmap::Iterator::operator*() const -> size_t {
+    return (*segments)[segment].base + word * 64 + __builtin_ctzll(bits);
+}
+
+auto MatchBitmap::Iterator::operator++() -> Iterator & {
+    bits &= bits - 1;
+    skip_empty();
+    return *this;
+}
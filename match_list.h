@@ -0,0 +1,159 @@
+#ifndef PARALLEL_MATCH_LIST_H
+#define PARALLEL_MATCH_LIST_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/// Ascending match offsets, stored as the LEB128 varint of the delta to the previous offset.
+///
+/// A list is made of segments. Each worker builds its own list starting from the base of its task, and lists are
+/// concatenated by moving segments, without decoding or re-encoding anything.
+class VarintMatchList {
+private:
+    struct Segment {
+        size_t base;
+        size_t count;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::vector<Segment> segments;
+    /// The last offset pushed, or the base of the last segment.
+    size_t last = 0;
+    size_t count = 0;
+
+public:
+    /// Decode offsets on the fly.
+    class Iterator {
+    private:
+        const std::vector<Segment> *segments = nullptr;
+        size_t segment = 0;
+        size_t position = 0;
+        size_t value = 0;
+
+        auto decode() -> void;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t *;
+        using reference = size_t;
+
+        Iterator() = default;
+
+        Iterator(const std::vector<Segment> *segments, size_t segment);
+
+        auto operator*() const -> size_t { return value; }
+
+        auto operator++() -> Iterator &;
+
+        auto operator++(int) -> Iterator {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        auto operator==(const Iterator &other) const -> bool {
+            return segment == other.segment && position == other.position;
+        }
+    };
+
+    /// Offsets pushed later must not be less than *base*.
+    explicit VarintMatchList(size_t base = 0);
+
+    /// Append an offset, which must not be less than the last one.
+    auto push_back(size_t offset) -> void;
+
+    /// Move all offsets of *other* to the end of this list. *other* must start after the last offset here.
+    auto append(VarintMatchList &&other) -> void;
+
+    auto size() const -> size_t { return count; }
+
+    /// Size of the encoded stream in bytes.
+    auto encoded_size() const -> size_t;
+
+    auto begin() const -> Iterator;
+
+    auto end() const -> Iterator;
+
+    auto to_vector() const -> std::vector<size_t>;
+};
+
+
+/// Match offsets stored as one bit per text position, for inputs where a large fraction of positions match.
+///
+/// Like VarintMatchList, each worker covers the range of its own task and bitmaps are concatenated by segments.
+class MatchBitmap {
+private:
+    struct Segment {
+        size_t base;
+        size_t length;
+        std::vector<uint64_t> words;
+    };
+
+    std::vector<Segment> segments;
+    size_t count = 0;
+
+public:
+    /// Iterate over set bits.
+    class Iterator {
+    private:
+        const std::vector<Segment> *segments = nullptr;
+        size_t segment = 0;
+        size_t word = 0;
+        uint64_t bits = 0;
+
+        auto skip_empty() -> void;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t *;
+        using reference = size_t;
+
+        Iterator() = default;
+
+        Iterator(const std::vector<Segment> *segments, size_t segment);
+
+        auto operator*() const -> size_t;
+
+        auto operator++() -> Iterator &;
+
+        auto operator++(int) -> Iterator {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        auto operator==(const Iterator &other) const -> bool {
+            return segment == other.segment && word == other.word && bits == other.bits;
+        }
+    };
+
+    MatchBitmap() = default;
+
+    /// Cover positions in [base, base + length).
+    MatchBitmap(size_t base, size_t length);
+
+    /// Mark an offset in the covered range. Offsets may be pushed in any order, but only once.
+    auto push_back(size_t offset) -> void;
+
+    /// Move all segments of *other* to the end of this bitmap. *other* must cover positions after this one.
+    auto append(MatchBitmap &&other) -> void;
+
+    auto size() const -> size_t { return count; }
+
+    /// Size of the bitmap in bytes.
+    auto encoded_size() const -> size_t;
+
+    auto begin() const -> Iterator;
+
+    auto end() const -> Iterator;
+
+    auto to_vector() const -> std::vector<size_t>;
+};
+
+#endif //PARALLEL_MATCH_LIST_H
@@ -10,6 +10,7 @@
 #include <format>
 #include <immintrin.h>
 #include "memory.h"
+#include "simd_search.h"
 
 
 auto
@@ -61,11 +62,20 @@ auto memrnd(uint8_t *p, const size_t size) -> void {
     }
 }
 
-/// Allocate a piece of memory and place *count* patterns in it randomly.
-auto generate_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void {
-    memrnd(base, size);
-//    memclr(base, size);
+/// Fill memory with bytes drawn from the built-in text profile.
+auto memtext(uint8_t *p, const size_t size) -> void {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    const auto &frequency = text_byte_frequency();
+    std::discrete_distribution<int> dis(frequency.begin(), frequency.end());
+
+    for (size_t i = 0; i < size; i++) {
+        p[i] = dis(gen);
+    }
+}
 
+/// Place *count* patterns evenly in the memory region, which is already filled.
+static auto place_patterns(uint8_t *base, size_t size, const char *pattern, size_t count) -> void {
     auto pattern_len = strlen(pattern);
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -91,4 +101,28 @@ auto generate_test_data(uint8_t *base, size_t size, const char *pattern, size_t
     if (!flag) {
         throw std::runtime_error("failed to place pattern in memory.");
     }
-}
\ No newline at end of file
+}
+
+/// Allocate a piece of memory and place *count* patterns in it randomly.
+auto generate_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void {
+    memrnd(base, size);
+//    memclr(base, size);
+    place_patterns(base, size, pattern, count);
+}
+
+/// Fill memory with text-like bytes and place *count* patterns in it randomly.
+auto generate_text_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void {
+    memtext(base, size);
+    place_patterns(base, size, pattern, count);
+}
+
+/// Fill memory with random nucleotides.
+auto generate_dna_test_data(uint8_t *base, size_t size) -> void {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<int> dis(0, 3);
+
+    for (size_t i = 0; i < size; i++) {
+        base[i] = "ACGT"[dis(gen)];
+    }
+}
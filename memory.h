@@ -10,4 +10,10 @@
 auto check_result_quickly(const uint8_t *p, size_t len, const char *pattern, const std::vector<size_t> &result) -> bool;
 
 /// Clear memory and place *count* patterns in it randomly.
-auto generate_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void;
\ No newline at end of file
+auto generate_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void;
+
+/// Fill memory with text-like bytes (skewed towards spaces and common letters) and place *count* patterns in it.
+auto generate_text_test_data(uint8_t *base, size_t size, const char *pattern, size_t count) -> void;
+
+/// Fill memory with random nucleotides (A, C, G, T), where short patterns match at a large fraction of positions.
+auto generate_dna_test_data(uint8_t *base, size_t size) -> void;
\ No newline at end of file
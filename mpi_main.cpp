@@ -0,0 +1,135 @@
+/// Find all occurrences of the pattern P, in a file F, sharded across MPI ranks, each of which runs OpenMP threads.
+///
+/// Usage: mpirun -np <ranks> ./parallel_mpi [file] [threads per rank]
+/// If no file is given, rank 0 generates a test file in the temporary directory first, and removes it at the end.
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <format>
+#include <string>
+#include <filesystem>
+#include <mpi.h>
+#include "mpi_search.h"
+#include "openmp_search.h"
+#include "file_mapper.h"
+#include "memory.h"
+#include "util.h"
+
+
+/// Write *size* bytes of test data with *count* patterns to *filename*.
+auto write_test_file(const char *filename, size_t size, const char *pattern, size_t count) -> void {
+    auto p = new uint8_t[size];
+    generate_test_data(p, size, pattern, count);
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(p), static_cast<std::streamsize>(size));
+    delete[] p;
+    if (!file) {
+        throw Exception("failed to write test file " + std::string(filename));
+    }
+}
+
+/// Run *search* several times on all ranks, and return the best wall time in microseconds.
+template<typename F>
+auto best_of(int rounds, MPI_Comm comm, F &&search) -> long {
+    long best = -1;
+    for (auto i = 0; i < rounds; i++) {
+        MPI_Barrier(comm);
+        auto start = std::chrono::high_resolution_clock::now();
+        search();
+        MPI_Barrier(comm);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        best = best < 0 ? duration : std::min(best, duration);
+    }
+    return best;
+}
+
+
+int main(int argc, char *argv[]) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int rank, ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    const auto TEST_FILE_SIZE = 512 * 1024 * 1024L;
+    const auto PATTERN = "PATTERN";
+    const auto PATTERN_COUNT = 5;
+    const auto ROUNDS = 3;
+
+    auto generated = argc <= 1;
+    auto filename = generated ? (std::filesystem::temp_directory_path() / "parallel_mpi_test.bin").string()
+                              : std::string(argv[1]);
+    auto threads = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 2u;
+
+    try {
+        if (threads == 0) {
+            throw Exception("threads per rank must be at least 1");
+        }
+        if (generated && rank == 0) {
+            write_test_file(filename.c_str(), TEST_FILE_SIZE, PATTERN, PATTERN_COUNT);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        // 单进程基准：rank 0 映射整个文件，使用与每个 rank 相同的线程数
+        std::vector<size_t> single_result;
+        size_t file_size = 0;
+        long single_duration = 0;
+        if (rank == 0) {
+            single_duration = best_of(ROUNDS, MPI_COMM_SELF, [&] {
+                FileMapper mapper(filename.c_str());
+                mapper.load();
+                file_size = mapper.get_size();
+                single_result = search_with_openmp_simd(mapper.get_start(), mapper.get_size(), PATTERN, threads).first;
+            });
+        }
+
+        std::vector<size_t> result;
+        auto mpi_duration = best_of(ROUNDS, MPI_COMM_WORLD, [&] {
+            result = mpi_search_file(filename.c_str(), PATTERN, threads, MPI_COMM_WORLD);
+        });
+        size_t count = 0;
+        auto count_duration = best_of(ROUNDS, MPI_COMM_WORLD, [&] {
+            count = mpi_count_file(filename.c_str(), PATTERN, threads, MPI_COMM_WORLD);
+        });
+
+        if (rank == 0) {
+            FileMapper mapper(filename.c_str());
+            mapper.load();
+            if (result != single_result || count != result.size()
+                || !check_result_quickly(mapper.get_start(), mapper.get_size(), PATTERN, result)) {
+                std::cerr << "MPI search test failed." << std::endl;
+            }
+
+            // 加速比相对于单进程 search_with_openmp_simd 计算，效率 = 加速比 / rank 数
+            auto speedup = single_duration * 1. / mpi_duration;
+            std::cout << std::format("file size: {}, {} matches, {} ranks x {} threads", display_size(file_size),
+                                     result.size(), ranks, threads) << std::endl;
+            std::cout << std::format("single process: {}, MPI gather: {}, MPI count: {}", display_time(single_duration),
+                                     display_time(mpi_duration), display_time(count_duration)) << std::endl;
+            std::cout << std::format("speedup: {:.2f}, efficiency: {:.0f}%", speedup, speedup * 100. / ranks)
+                      << std::endl;
+        }
+
+        // 所有 rank 都已解除映射后再删除测试文件
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (generated && rank == 0) {
+            std::filesystem::remove(filename);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "rank " << rank << ": " << e.what() << std::endl;
+        if (generated && rank == 0) {
+            std::error_code error;
+            std::filesystem::remove(filename, error);
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <cstring>
+#include <climits>
+#include <filesystem>
+#include "mpi_search.h"
+#include "openmp_search.h"
+#include "file_mapper.h"
+#include "task.h"
+#include "exception.h"
+
+
+/// Map the shard of this rank and search it. Offsets are relative to the start of the file.
+static auto search_shard(const char *filename, const char *pattern, unsigned int threads, MPI_Comm comm)
+-> std::vector<size_t> {
+    int rank, ranks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ranks);
+
+    auto file_size = std::filesystem::file_size(filename);
+    auto task = split_tasks(file_size, strlen(pattern) - 1, ranks)[rank];
+
+    FileMapper mapper(filename);
+    mapper.load(task.offset, task.size);
+    return search_with_openmp_simd(mapper.get_start(), mapper.get_size(), pattern, threads, task.offset).first;
+}
+
+auto mpi_search_file(const char *filename, const char *pattern, unsigned int threads, MPI_Comm comm)
+-> std::vector<size_t> {
+    int rank, ranks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ranks);
+
+    auto local = search_shard(filename, pattern, threads, comm);
+    auto local_offsets = std::vector<uint64_t>(local.begin(), local.end());
+
+    // Collect the count from each rank first, so that rank 0 knows where to put the offsets. MPI_Gatherv takes int
+    // counts and displacements, so the total has to fit in an int; all ranks must agree before the gather.
+    uint64_t local_count = local_offsets.size();
+    auto counts64 = std::vector<uint64_t>(rank == 0 ? ranks : 0);
+    MPI_Gather(&local_count, 1, MPI_UINT64_T, counts64.data(), 1, MPI_UINT64_T, 0, comm);
+
+    uint64_t total = 0;
+    for (auto count: counts64) total += count;
+    int fits = total <= static_cast<uint64_t>(INT_MAX);
+    MPI_Bcast(&fits, 1, MPI_INT, 0, comm);
+    if (!fits) {
+        throw Exception("too many matches to gather to rank 0, use mpi_count_file instead");
+    }
+
+    auto counts = std::vector<int>(counts64.begin(), counts64.end());
+    auto displacements = std::vector<int>(counts.size());
+    for (size_t i = 1; i < counts.size(); i++) {
+        displacements[i] = displacements[i - 1] + counts[i - 1];
+    }
+
+    // Shards are ordered by rank, so the gathered offsets are already sorted.
+    auto offsets = std::vector<uint64_t>(total);
+    MPI_Gatherv(local_offsets.data(), static_cast<int>(local_count), MPI_UINT64_T, offsets.data(), counts.data(),
+                displacements.data(), MPI_UINT64_T, 0, comm);
+
+    return {offsets.begin(), offsets.end()};
+}
+
+auto mpi_count_file(const char *filename, const char *pattern, unsigned int threads, MPI_Comm comm) -> size_t {
+    uint64_t local_count = search_shard(filename, pattern, threads, comm).size();
+    uint64_t total = 0;
+    MPI_Reduce(&local_count, &total, 1, MPI_UINT64_T, MPI_SUM, 0, comm);
+    return total;
+}
@@ -0,0 +1,19 @@
+#ifndef PARALLEL_MPI_SEARCH_H
+#define PARALLEL_MPI_SEARCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <mpi.h>
+
+/// Shard the file across the ranks of *comm*. Each rank maps its own byte range plus a `pattern_len - 1` halo, and
+/// searches it with `search_with_openmp_simd` on *threads* OpenMP threads. File offsets of all matches are gathered
+/// to rank 0, in ascending order; other ranks get an empty vector. Throws an Exception on all ranks if there are more
+/// than INT_MAX matches, which MPI_Gatherv cannot collect.
+auto mpi_search_file(const char *filename, const char *pattern, unsigned int threads, MPI_Comm comm)
+-> std::vector<size_t>;
+
+/// Like mpi_search_file, but only the total count of matches is reduced to rank 0. Other ranks get 0.
+auto mpi_count_file(const char *filename, const char *pattern, unsigned int threads, MPI_Comm comm) -> size_t;
+
+#endif //PARALLEL_MPI_SEARCH_H
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <cstring>
+#include <omp.h>
+#include "openmp_search.h"
+#include "simd_search.h"
+#include "task.h"
+
+
+auto search_with_openmp_simd(const uint8_t *p, size_t total_length, const char *pattern, const unsigned int threads,
+                             size_t base)
+-> std::pair<std::vector<size_t>, long> {
+
+    // Generate tasks, each of them overlaps the next one by `pattern_len - 1` bytes.
+    auto base_addr = p;
+    auto pattern_len = strlen(pattern);
+    auto tasks = split_tasks(total_length, pattern_len - 1, threads);
+
+    auto mid_result = std::vector<std::vector<size_t>>(threads);
+    auto start = std::chrono::high_resolution_clock::now();
+    // Assign tasks to threads.
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto task = tasks[index];
+
+        auto [_offset, _size] = task;
+        auto result = simd_search(reinterpret_cast<const char *>(base_addr + _offset), _size, pattern, strlen(pattern));
+
+        // simd_search only returns the offset to the pattern from the start of the block, not the base address.
+        for (auto &r: result) {
+            r += base + _offset;
+        }
+        mid_result[index] = std::move(result);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    auto result = std::vector<size_t>();
+    for (auto &r: mid_result) {
+        result.insert(result.end(), r.begin(), r.end());
+    }
+
+    return {result, duration};
+}
@@ -0,0 +1,16 @@
+#ifndef PARALLEL_OPENMP_SEARCH_H
+#define PARALLEL_OPENMP_SEARCH_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/// Search p[0, total_length) with *threads* OpenMP threads, each running `simd_search` on its own task. Offsets in the
+/// result are shifted by *base*, so that a shard of a larger input reports global offsets. Also returns the time
+/// spent searching, in microseconds.
+auto search_with_openmp_simd(const uint8_t *p, size_t total_length, const char *pattern, const unsigned int threads,
+                             size_t base = 0)
+-> std::pair<std::vector<size_t>, long>;
+
+#endif //PARALLEL_OPENMP_SEARCH_H
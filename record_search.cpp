@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <immintrin.h>
+#include <omp.h>
+#include "record_search.h"
+#include "simd_search.h"
+#include "task.h"
+
+
+/// Index of the record which may hold position *h*, i.e. the last record in [record, end) starting at or before *h*.
+/// Positions are looked up in ascending order, so the search starts from the previous result.
+static auto find_record(const size_t *offsets, size_t record, size_t end, size_t h) -> size_t {
+    // Gallop forward until offsets[lo] <= h < offsets[hi].
+    size_t lo = record, hi = record + 1;
+    for (size_t step = 1; hi < end && offsets[hi] <= h; step *= 2) {
+        lo = hi;
+        hi = std::min(end, hi + step);
+    }
+    while (hi - lo > 16) {
+        auto mid = lo + (hi - lo) / 2;
+        if (offsets[mid] <= h) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Compare the last few boundaries with SIMD, 4 at a time.
+    const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(h));
+    auto i = lo + 1;
+    for (; i + 4 <= hi; i += 4) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets + i));
+        auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(block, needle)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask) - 1;
+        }
+    }
+    for (; i < hi; i++) {
+        if (offsets[i] > h) return i - 1;
+    }
+    return hi - 1;
+}
+
+auto search_records(const char *buffer, const size_t *offsets, const size_t *lengths, const size_t record_count,
+                    const char *pattern, const size_t pattern_len, const unsigned int threads)
+-> std::vector<RecordMatch> {
+    if (record_count == 0 || pattern_len == 0) {
+        return {};
+    }
+
+    // Give each thread whole records, about the same number of bytes.
+    auto begin_offset = offsets[0];
+    auto end_offset = offsets[record_count - 1] + lengths[record_count - 1];
+    auto tasks = split_tasks(end_offset - begin_offset, 0, threads);
+    auto groups = std::vector<size_t>(threads + 1, record_count);
+    for (unsigned int i = 0; i < threads; i++) {
+        groups[i] = std::lower_bound(offsets, offsets + record_count, begin_offset + tasks[i].offset) - offsets;
+    }
+
+    auto mid_result = std::vector<std::vector<RecordMatch>>(threads);
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto record_begin = groups[index];
+        auto record_end = groups[index + 1];
+
+        if (record_begin < record_end) {
+            // One pass over all records of the group, including the gaps between them.
+            auto scan_begin = offsets[record_begin];
+            auto scan_end = offsets[record_end - 1] + lengths[record_end - 1];
+            auto hits = simd_search(buffer + scan_begin, scan_end - scan_begin, pattern, pattern_len);
+
+            auto &result = mid_result[index];
+            auto record = record_begin;
+            for (auto hit: hits) {
+                auto h = scan_begin + hit;
+                record = find_record(offsets, record, record_end, h);
+                if (h + pattern_len <= offsets[record] + lengths[record]) {
+                    result.push_back({record, h - offsets[record]});
+                }
+            }
+        }
+    }
+
+    auto result = std::vector<RecordMatch>();
+    for (auto &r: mid_result) {
+        result.insert(result.end(), r.begin(), r.end());
+    }
+    return result;
+}
@@ -0,0 +1,24 @@
+#ifndef PARALLEL_RECORD_SEARCH_H
+#define PARALLEL_RECORD_SEARCH_H
+
+#include <vector>
+#include <cstddef>
+
+/// A match in record *record*, at *offset* from the start of the record.
+struct RecordMatch {
+    size_t record;
+    size_t offset;
+
+    auto operator==(const RecordMatch &other) const -> bool = default;
+};
+
+/// Search many short records at once. Record i is buffer[offsets[i], offsets[i] + lengths[i]); records must be in
+/// ascending order and must not overlap, but there may be gaps (e.g. separators) between them.
+///
+/// Instead of one `simd_search` per record, the SIMD filter runs over each thread's share of the buffer in one pass,
+/// and hits are mapped back to records afterwards. Matches crossing the end of a record are dropped.
+auto search_records(const char *buffer, const size_t *offsets, const size_t *lengths, const size_t record_count,
+                    const char *pattern, const size_t pattern_len, const unsigned int threads = 1)
+-> std::vector<RecordMatch>;
+
+#endif //PARALLEL_RECORD_SEARCH_H
@@ -0,0 +1,781 @@
+// Reference:
+// https://swtch.com/~rsc/regexp/regexp1.html
+
+#include <map>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <cctype>
+#include "regex_search.h"
+#include "simd_search.h"
+#include "exception.h"
+
+
+namespace {
+
+    constexpr size_t UNBOUNDED = Regex::UNBOUNDED;
+    /// Counted repetitions are expanded, so keep them small.
+    constexpr size_t MAX_REPEAT = 1000;
+    constexpr size_t MAX_NFA_STATES = 100000;
+    /// The lazy DFA throws its cache away once it holds this many states.
+    constexpr size_t MAX_DFA_STATES = 4096;
+
+    struct Node {
+        enum Kind {
+            Chars,
+            Concat,
+            Alternate,
+            Repeat,
+        } kind;
+        std::bitset<256> chars;
+        std::vector<Node> children;
+        size_t min = 0;
+        size_t max = 0;
+    };
+
+    auto make_chars(const std::bitset<256> &chars) -> Node {
+        Node node{Node::Chars};
+        node.chars = chars;
+        return node;
+    }
+
+    auto saturating_add(size_t a, size_t b) -> size_t {
+        return (a == UNBOUNDED || b == UNBOUNDED || a > UNBOUNDED - b) ? UNBOUNDED : a + b;
+    }
+
+    auto saturating_mul(size_t a, size_t b) -> size_t {
+        if (a == 0 || b == 0) return 0;
+        return (a == UNBOUNDED || b == UNBOUNDED || a > UNBOUNDED / b) ? UNBOUNDED : a * b;
+    }
+
+
+    class Parser {
+    private:
+        const char *expression;
+        const char *p;
+
+        /// A parsed escape or class item, and the byte it stands for if it is a single one.
+        struct Item {
+            std::bitset<256> chars;
+            int single = -1;
+        };
+
+        [[noreturn]] auto fail(const std::string &reason) const -> void {
+            throw Exception("invalid regex \"" + std::string(expression) + "\": " + reason);
+        }
+
+        static auto single(unsigned char c) -> Item {
+            Item item;
+            item.chars.set(c);
+            item.single = c;
+            return item;
+        }
+
+        static auto range(unsigned char lo, unsigned char hi) -> std::bitset<256> {
+            std::bitset<256> chars;
+            for (auto c = static_cast<unsigned>(lo); c <= hi; c++) {
+                chars.set(c);
+            }
+            return chars;
+        }
+
+        /// Parse the escape after a backslash.
+        auto parse_escape() -> Item {
+            auto c = static_cast<unsigned char>(*p);
+            if (c == 0) fail("trailing backslash");
+            p++;
+
+            Item item;
+            switch (c) {
+                case 'd':
+                case 'D':
+                    item.chars = range('0', '9');
+                    break;
+                case 'w':
+                case 'W':
+                    item.chars = range('a', 'z') | range('A', 'Z') | range('0', '9');
+                    item.chars.set('_');
+                    break;
+                case 's':
+                case 'S':
+                    for (auto space: " \t\n\r\f\v") {
+                        if (space) item.chars.set(static_cast<unsigned char>(space));
+                    }
+                    break;
+                case 'n':
+                    return single('\n');
+                case 't':
+                    return single('\t');
+                case 'r':
+                    return single('\r');
+                default:
+                    if (std::isalnum(c)) fail(std::string("unknown escape \\") + static_cast<char>(c));
+                    return single(c);
+            }
+            if (std::isupper(c)) item.chars.flip();
+            return item;
+        }
+
+        auto parse_class_item() -> Item {
+            if (*p == '\\') {
+                p++;
+                return parse_escape();
+            }
+            return single(static_cast<unsigned char>(*p++));
+        }
+
+        auto parse_class() -> Node {
+            p++;
+            auto negate = *p == '^';
+            if (negate) p++;
+
+            std::bitset<256> chars;
+            // A ']' right after '[' or '[^' is a literal.
+            auto first = true;
+            while (*p && (*p != ']' || first)) {
+                first = false;
+                auto item = parse_class_item();
+                if (item.single >= 0 && p[0] == '-' && p[1] && p[1] != ']') {
+                    p++;
+                    auto hi = parse_class_item();
+                    if (hi.single < 0 || hi.single < item.single) fail("invalid range in class");
+                    chars |= range(item.single, hi.single);
+                } else {
+                    chars |= item.chars;
+                }
+            }
+            if (*p != ']') fail("missing ']'");
+            p++;
+
+            if (negate) chars.flip();
+            return make_chars(chars);
+        }
+
+        /// Parse {m}, {m,} or {m,n}. Anything else is not a quantifier, and '{' is taken as a literal.
+        auto parse_bounds(size_t &min, size_t &max) -> bool {
+            auto q = p + 1;
+            auto read_number = [&](size_t &value) {
+                if (!std::isdigit(static_cast<unsigned char>(*q))) return false;
+                value = 0;
+                while (std::isdigit(static_cast<unsigned char>(*q))) {
+                    value = value * 10 + (*q++ - '0');
+                    if (value > MAX_REPEAT) fail("repetition count is too large");
+                }
+                return true;
+            };
+
+            if (!read_number(min)) return false;
+            if (*q == ',') {
+                q++;
+                if (*q == '}') {
+                    max = UNBOUNDED;
+                } else if (!read_number(max)) {
+                    return false;
+                }
+            } else {
+                max = min;
+            }
+            if (*q != '}') return false;
+            if (max < min) fail("invalid repetition bounds");
+
+            p = q + 1;
+            return true;
+        }
+
+        auto parse_atom() -> Node {
+            switch (*p) {
+                case '(': {
+                    p++;
+                    auto node = parse_alternate();
+                    if (*p != ')') fail("missing ')'");
+                    p++;
+                    return node;
+                }
+                case '[':
+                    return parse_class();
+                case '.': {
+                    p++;
+                    std::bitset<256> chars;
+                    chars.set();
+                    chars.reset('\n');
+                    return make_chars(chars);
+                }
+                case '\\':
+                    p++;
+                    return make_chars(parse_escape().chars);
+                case '*':
+                case '+':
+                case '?':
+                    fail("nothing to repeat");
+                case '^':
+                case '$':
+                    fail("anchors are not supported");
+                default:
+                    return make_chars(single(static_cast<unsigned char>(*p++)).chars);
+            }
+        }
+
+        auto parse_repeat() -> Node {
+            auto atom = parse_atom();
+            while (true) {
+                size_t min, max;
+                if (*p == '*') {
+                    min = 0, max = UNBOUNDED;
+                    p++;
+                } else if (*p == '+') {
+                    min = 1, max = UNBOUNDED;
+                    p++;
+                } else if (*p == '?') {
+                    min = 0, max = 1;
+                    p++;
+                } else if (*p != '{' || !parse_bounds(min, max)) {
+                    break;
+                }
+                if (*p == '?') fail("lazy quantifiers are not supported");
+
+                Node node{Node::Repeat};
+                node.min = min;
+                node.max = max;
+                node.children.push_back(std::move(atom));
+                atom = std::move(node);
+            }
+            return atom;
+        }
+
+        auto parse_concat() -> Node {
+            Node node{Node::Concat};
+            while (*p && *p != '|' && *p != ')') {
+                node.children.push_back(parse_repeat());
+            }
+            return node;
+        }
+
+        auto parse_alternate() -> Node {
+            auto first = parse_concat();
+            if (*p != '|') return first;
+
+            Node node{Node::Alternate};
+            node.children.push_back(std::move(first));
+            while (*p == '|') {
+                p++;
+                node.children.push_back(parse_concat());
+            }
+            return node;
+        }
+
+    public:
+        explicit Parser(const char *expression) : expression(expression), p(expression) {}
+
+        auto parse() -> Node {
+            auto node = parse_alternate();
+            if (*p) fail("unmatched ')'");
+            return node;
+        }
+    };
+
+
+    auto min_length(const Node &node) -> size_t {
+        switch (node.kind) {
+            case Node::Chars:
+                return 1;
+            case Node::Concat: {
+                size_t length = 0;
+                for (const auto &child: node.children) length = saturating_add(length, min_length(child));
+                return length;
+            }
+            case Node::Alternate: {
+                auto length = UNBOUNDED;
+                for (const auto &child: node.children) length = std::min(length, min_length(child));
+                return length;
+            }
+            case Node::Repeat:
+                return saturating_mul(min_length(node.children[0]), node.min);
+        }
+        return 0;
+    }
+
+    auto max_length(const Node &node) -> size_t {
+        switch (node.kind) {
+            case Node::Chars:
+                return 1;
+            case Node::Concat: {
+                size_t length = 0;
+                for (const auto &child: node.children) length = saturating_add(length, max_length(child));
+                return length;
+            }
+            case Node::Alternate: {
+                size_t length = 0;
+                for (const auto &child: node.children) length = std::max(length, max_length(child));
+                return length;
+            }
+            case Node::Repeat:
+                return saturating_mul(max_length(node.children[0]), node.max);
+        }
+        return 0;
+    }
+
+    /// The byte matched by *node*, if it matches exactly one byte.
+    auto single_char(const Node &node) -> int {
+        if (node.kind != Node::Chars || node.chars.count() != 1) return -1;
+        for (auto c = 0; c < 256; c++) {
+            if (node.chars.test(c)) return c;
+        }
+        return -1;
+    }
+
+    auto flatten(const Node &node, std::vector<const Node *> &items) -> void {
+        if (node.kind == Node::Concat) {
+            for (const auto &child: node.children) flatten(child, items);
+        } else {
+            items.push_back(&node);
+        }
+    }
+
+    /// The longest run of literal bytes at the top level of *node*. Runs at a bounded distance from the start are
+    /// preferred, as they pin down where the match starts.
+    auto extract_literal(const Node &node) -> std::optional<RegexLiteral> {
+        std::vector<const Node *> items;
+        flatten(node, items);
+
+        std::optional<RegexLiteral> best;
+        size_t min_before = 0, max_before = 0;
+        for (size_t i = 0; i < items.size();) {
+            if (single_char(*items[i]) < 0) {
+                min_before = saturating_add(min_before, min_length(*items[i]));
+                max_before = saturating_add(max_before, max_length(*items[i]));
+                i++;
+                continue;
+            }
+
+            RegexLiteral run{"", min_before, max_before};
+            for (int c; i < items.size() && (c = single_char(*items[i])) >= 0; i++) {
+                run.literal += static_cast<char>(c);
+            }
+            min_before = saturating_add(min_before, run.literal.size());
+            max_before = saturating_add(max_before, run.literal.size());
+
+            auto better = [](const RegexLiteral &a, const RegexLiteral &b) {
+                return std::make_pair(a.max_before != UNBOUNDED, a.literal.size()) >
+                       std::make_pair(b.max_before != UNBOUNDED, b.literal.size());
+            };
+            if (!best || better(run, *best)) {
+                best = std::move(run);
+            }
+        }
+        return best;
+    }
+
+    /// Literals of which any match contains one. For an alternation, each branch must have its own.
+    auto extract_literals(const Node &node) -> std::vector<RegexLiteral> {
+        std::vector<RegexLiteral> literals;
+        if (node.kind != Node::Alternate) {
+            if (auto literal = extract_literal(node)) literals.push_back(std::move(*literal));
+            return literals;
+        }
+
+        for (const auto &child: node.children) {
+            auto literal = extract_literal(child);
+            if (!literal) return {};
+            literals.push_back(std::move(*literal));
+        }
+        return literals;
+    }
+
+
+    /// Build the Thompson NFA backwards: each node is compiled with the state it continues to.
+    class Compiler {
+    private:
+        std::vector<Regex::NfaState> &states;
+
+    public:
+        explicit Compiler(std::vector<Regex::NfaState> &states) : states(states) {}
+
+        auto add(Regex::NfaState state) -> int {
+            if (states.size() >= MAX_NFA_STATES) {
+                throw Exception("regex is too large");
+            }
+            states.push_back(state);
+            return static_cast<int>(states.size() - 1);
+        }
+
+        auto compile(const Node &node, int next) -> int {
+            switch (node.kind) {
+                case Node::Chars:
+                    return add({Regex::NfaState::Char, node.chars, next});
+                case Node::Concat:
+                    for (auto it = node.children.rbegin(); it != node.children.rend(); it++) {
+                        next = compile(*it, next);
+                    }
+                    return next;
+                case Node::Alternate: {
+                    auto state = compile(node.children.back(), next);
+                    for (auto i = node.children.size() - 1; i-- > 0;) {
+                        state = add({Regex::NfaState::Split, {}, compile(node.children[i], next), state});
+                    }
+                    return state;
+                }
+                case Node::Repeat: {
+                    const auto &child = node.children[0];
+                    auto tail = next;
+                    if (node.max == UNBOUNDED) {
+                        auto loop = add({Regex::NfaState::Split, {}, -1, next});
+                        states[loop].out = compile(child, loop);
+                        tail = loop;
+                    } else {
+                        // x{0,2} is compiled as (x(x)?)?
+                        for (auto k = node.min; k < node.max; k++) {
+                            tail = add({Regex::NfaState::Split, {}, compile(child, tail), next});
+                        }
+                    }
+                    for (size_t k = 0; k < node.min; k++) {
+                        tail = compile(child, tail);
+                    }
+                    return tail;
+                }
+            }
+            return next;
+        }
+    };
+
+
+    /// The same regex read from right to left, which matches the reversed text.
+    auto reverse(Node node) -> Node {
+        if (node.kind == Node::Concat) {
+            std::reverse(node.children.begin(), node.children.end());
+        }
+        for (auto &child: node.children) {
+            child = reverse(std::move(child));
+        }
+        return node;
+    }
+
+
+    /// DFA built from the NFA on demand, one state per set of NFA states. Each thread owns its own.
+    class LazyDfa {
+    private:
+        const std::vector<Regex::NfaState> &nfa;
+        int nfa_start;
+
+        std::vector<std::vector<int>> sets;
+        std::vector<std::array<int, 256>> transitions;
+        /// Transitions from the state with the NFA start state added, i.e. where a new match may also begin.
+        std::vector<std::array<int, 256>> restarted_transitions;
+        std::vector<char> accepting;
+        std::map<std::vector<int>, int> index;
+        /// Counts cache flushes; state numbers from before a flush are invalid.
+        size_t flushes = 0;
+
+        std::vector<unsigned> marks;
+        unsigned generation = 0;
+        std::vector<int> stack;
+
+        /// NFA states reachable from *seeds* without consuming input. Split states are left out.
+        auto closure(const std::vector<int> &seeds) -> std::vector<int> {
+            generation++;
+            std::vector<int> result;
+            stack.assign(seeds.begin(), seeds.end());
+            while (!stack.empty()) {
+                auto s = stack.back();
+                stack.pop_back();
+                if (marks[s] == generation) continue;
+                marks[s] = generation;
+
+                const auto &state = nfa[s];
+                if (state.kind == Regex::NfaState::Split) {
+                    stack.push_back(state.out1);
+                    stack.push_back(state.out);
+                } else {
+                    result.push_back(s);
+                }
+            }
+            std::sort(result.begin(), result.end());
+            return result;
+        }
+
+        /// Add *set* to the cache. The cache is flushed first if it is full; the callers only keep the state
+        /// returned here.
+        auto add_state(std::vector<int> set) -> int {
+            if (auto it = index.find(set); it != index.end()) return it->second;
+            if (sets.size() >= MAX_DFA_STATES) {
+                reset();
+            }
+            auto [it, inserted] = index.emplace(set, static_cast<int>(sets.size()));
+
+            accepting.push_back(std::any_of(set.begin(), set.end(), [&](int s) {
+                return nfa[s].kind == Regex::NfaState::Match;
+            }));
+            transitions.emplace_back().fill(-1);
+            restarted_transitions.emplace_back().fill(-1);
+            sets.push_back(std::move(set));
+            return it->second;
+        }
+
+        auto reset() -> void {
+            flushes++;
+            sets.clear();
+            transitions.clear();
+            restarted_transitions.clear();
+            accepting.clear();
+            index.clear();
+
+            add_state({});
+            transitions[DEAD].fill(DEAD);
+            start = add_state(closure({nfa_start}));
+        }
+
+        auto step(const std::vector<int> &set, uint8_t byte) -> int {
+            std::vector<int> seeds;
+            for (auto s: set) {
+                if (nfa[s].kind == Regex::NfaState::Char && nfa[s].chars.test(byte)) {
+                    seeds.push_back(nfa[s].out);
+                }
+            }
+            return add_state(closure(seeds));
+        }
+
+    public:
+        static constexpr int DEAD = 0;
+        int start = DEAD;
+
+        LazyDfa(const std::vector<Regex::NfaState> &nfa, int nfa_start)
+                : nfa(nfa), nfa_start(nfa_start), marks(nfa.size()) {
+            reset();
+        }
+
+        auto is_accepting(int state) const -> bool {
+            return accepting[state];
+        }
+
+        auto next(int state, uint8_t byte) -> int {
+            auto target = transitions[state][byte];
+            if (target >= 0) return target;
+
+            auto epoch = flushes;
+            target = step(sets[state], byte);
+            if (epoch == flushes) transitions[state][byte] = target;
+            return target;
+        }
+
+        /// Like next, but a match may also start before *byte*. Scanning with it finds matches starting anywhere.
+        auto next_restarted(int state, uint8_t byte) -> int {
+            auto target = restarted_transitions[state][byte];
+            if (target >= 0) return target;
+
+            auto epoch = flushes;
+            auto set = sets[state];
+            set.push_back(nfa_start);
+            target = step(closure(set), byte);
+            if (epoch == flushes) restarted_transitions[state][byte] = target;
+            return target;
+        }
+    };
+
+    constexpr size_t NO_MATCH = SIZE_MAX;
+
+    /// End of the longest match starting at text[from], or NO_MATCH.
+    auto longest_match(LazyDfa &dfa, const uint8_t *text, size_t from, size_t text_len) -> size_t {
+        auto state = dfa.start;
+        auto end = dfa.is_accepting(state) ? from : NO_MATCH;
+        for (auto i = from; i < text_len; i++) {
+            state = dfa.next(state, text[i]);
+            if (state == LazyDfa::DEAD) break;
+            if (dfa.is_accepting(state)) end = i + 1;
+        }
+        return end;
+    }
+
+    /// Position where the scan continues after *match*. An empty match moves it one byte forward.
+    auto resume_after(const RegexMatch &match) -> size_t {
+        return match.end > match.start ? match.end : match.start + 1;
+    }
+
+    using Intervals = std::vector<std::pair<size_t, size_t>>;
+
+    /// Sorted, disjoint intervals of [from, owned) which may contain the start of a match.
+    auto candidate_starts(const Regex &regex, const char *text, size_t text_len, size_t from, size_t owned)
+    -> Intervals {
+        const auto &literals = regex.required_literals();
+        if (literals.empty()) {
+            return from < owned ? Intervals{{from, owned}} : Intervals{};
+        }
+
+        // A literal found at h belongs to a match starting in [h - max_before, h - min_before].
+        Intervals windows;
+        for (const auto &[literal, min_before, max_before]: literals) {
+            auto literal_len = literal.size();
+            auto search_begin = std::min(from + min_before, text_len);
+            auto search_end = max_before == UNBOUNDED ? text_len
+                                                      : std::min(owned + max_before + literal_len - 1, text_len);
+            if (from >= owned || search_end <= search_begin) continue;
+
+            auto anchors = select_anchors(literal.data(), literal_len, text_byte_frequency());
+            auto hits = simd_search(text + search_begin, search_end - search_begin, literal.data(), literal_len, anchors);
+            for (auto hit: hits) {
+                auto h = hit + search_begin;
+                auto lo = (max_before == UNBOUNDED || h < max_before) ? from : std::max(h - max_before, from);
+                auto hi = std::min(h - min_before + 1, owned);
+                if (lo < hi) windows.emplace_back(lo, hi);
+            }
+        }
+        std::sort(windows.begin(), windows.end());
+
+        Intervals merged;
+        for (auto [lo, hi]: windows) {
+            if (!merged.empty() && lo <= merged.back().second) {
+                merged.back().second = std::max(merged.back().second, hi);
+            } else {
+                merged.emplace_back(lo, hi);
+            }
+        }
+        return merged;
+    }
+
+    /// Leftmost-longest, non-overlapping matches starting in text[from, owned), at most *limit* of them. If *owned*
+    /// reaches the end of the text, an empty match may also start at text_len.
+    ///
+    /// A forward pass over the candidate intervals finds segments of the text where some match may be in progress,
+    /// and where the last one ends. A reverse pass over each segment marks the positions where a match starts, and
+    /// only from those the longest match is taken. Every byte is visited a bounded number of times, apart from the
+    /// tails of the longest matches.
+    auto find_matches(const Regex &regex, const char *text, size_t text_len, size_t from, size_t owned, size_t limit)
+    -> std::vector<RegexMatch> {
+        std::vector<RegexMatch> result;
+        auto nullable = regex.min_length() == 0;
+        // A regex matching the empty string also matches at the end of the text, after the last byte.
+        owned = (nullable && owned >= text_len) ? text_len + 1 : std::min(owned, text_len);
+        auto intervals = candidate_starts(regex, text, text_len, from, owned);
+        if (intervals.empty()) return result;
+
+        LazyDfa forward(regex.get_states(), regex.get_start());
+        LazyDfa backward(regex.get_reverse_states(), regex.get_reverse_start());
+        auto bytes = reinterpret_cast<const uint8_t *>(text);
+        std::vector<char> starts;
+
+        size_t index = 0;
+        size_t position = from;
+        while (index < intervals.size()) {
+            auto segment_begin = std::max(intervals[index].first, position);
+            if (segment_begin >= intervals[index].second) {
+                index++;
+                continue;
+            }
+
+            // Run the automaton until no match started in a candidate interval is in progress. An empty match ends
+            // wherever one can start.
+            auto first_interval = index;
+            auto state = LazyDfa::DEAD;
+            auto last_end = NO_MATCH;
+            auto i = segment_begin;
+            while (true) {
+                while (index < intervals.size() && intervals[index].second <= i) index++;
+                auto restart = index < intervals.size() && i >= intervals[index].first;
+                if (restart && nullable) last_end = i;
+                if (i >= text_len || (!restart && state == LazyDfa::DEAD)) break;
+
+                state = restart ? forward.next_restarted(state, bytes[i]) : forward.next(state, bytes[i]);
+                i++;
+                if (forward.is_accepting(state)) last_end = i;
+            }
+            // Nothing starts after the end of the text, not even an empty match.
+            position = i < text_len ? i : text_len + 1;
+            if (last_end == NO_MATCH) continue;
+
+            // Scan the segment backwards with the reversed regex, restarting at every position: a match starts at
+            // j if the reversed regex matches text[j, last_end] read backwards.
+            starts.assign(last_end - segment_begin + 1, 0);
+            starts[last_end - segment_begin] = nullable;
+            state = LazyDfa::DEAD;
+            for (auto j = last_end; j-- > segment_begin;) {
+                state = backward.next_restarted(state, bytes[j]);
+                starts[j - segment_begin] = nullable || backward.is_accepting(state);
+            }
+
+            auto k = first_interval;
+            for (auto start = segment_begin; start <= last_end && start < owned; start++) {
+                if (!starts[start - segment_begin]) continue;
+                while (k < intervals.size() && intervals[k].second <= start) k++;
+                if (k == intervals.size()) break;
+                if (start < intervals[k].first) continue;
+
+                RegexMatch match{start, longest_match(forward, bytes, start, text_len)};
+                result.push_back(match);
+                if (result.size() == limit) return result;
+                start = resume_after(match) - 1;
+            }
+        }
+        return result;
+    }
+
+} // namespace
+
+
+Regex::Regex(const char *expression) {
+    auto root = Parser(expression).parse();
+
+    min_len = ::min_length(root);
+    max_len = ::max_length(root);
+    literals = extract_literals(root);
+
+    Compiler compiler(states);
+    start = compiler.compile(root, compiler.add({NfaState::Match}));
+
+    Compiler reverse_compiler(reverse_states);
+    reverse_start = reverse_compiler.compile(reverse(std::move(root)), reverse_compiler.add({NfaState::Match}));
+}
+
+auto regex_search(const Regex &regex, const char *text, const size_t text_len, const size_t owned_len)
+-> std::vector<RegexMatch> {
+    return find_matches(regex, text, text_len, 0, owned_len, SIZE_MAX);
+}
+
+auto regex_search(const Regex &regex, const char *text, const size_t text_len) -> std::vector<RegexMatch> {
+    return regex_search(regex, text, text_len, text_len);
+}
+
+auto regex_overlap(const Regex &regex, const size_t total_length) -> size_t {
+    auto max_len = regex.max_length();
+    if (max_len == Regex::UNBOUNDED) {
+        return total_length;
+    }
+    return max_len > 0 ? max_len - 1 : 0;
+}
+
+auto regex_join(const Regex &regex, const char *text, const size_t total_length, const std::vector<Task> &tasks,
+                std::vector<std::vector<RegexMatch>> &&results) -> std::vector<RegexMatch> {
+    std::vector<RegexMatch> joined;
+    // Where the sequential scan continues.
+    size_t resume = 0;
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        auto [offset, size] = tasks[i];
+        auto owned = (i + 1 < tasks.size() ? tasks[i + 1].offset : total_length) - offset;
+        const auto &part = results[i];
+        resume = std::max(resume, offset);
+
+        // The task scanned from its own offset. Once it continues at or before the sequential scan, without a match
+        // in between, the rest of its matches are the same; until then, find the matches one by one.
+        size_t k = 0;
+        auto task_resume = offset;
+        while (true) {
+            while (k < part.size() && part[k].start < resume) {
+                task_resume = resume_after(part[k++]);
+            }
+            if (task_resume <= resume) break;
+
+            auto found = find_matches(regex, text + offset, size, resume - offset, owned, 1);
+            if (found.empty()) {
+                k = part.size();
+                break;
+            }
+            RegexMatch match{found[0].start + offset, found[0].end + offset};
+            joined.push_back(match);
+            resume = resume_after(match);
+        }
+
+        for (; k < part.size(); k++) {
+            joined.push_back(part[k]);
+            resume = resume_after(part[k]);
+        }
+    }
+    return joined;
+}
@@ -0,0 +1,97 @@
+#ifndef PARALLEL_REGEX_SEARCH_H
+#define PARALLEL_REGEX_SEARCH_H
+
+#include <bitset>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "task.h"
+
+/// A match of a regex, covering text[start, end).
+struct RegexMatch {
+    size_t start;
+    size_t end;
+
+    auto operator==(const RegexMatch &other) const -> bool = default;
+};
+
+/// A literal which every match contains, *min_before* to *max_before* bytes after the start of the match.
+struct RegexLiteral {
+    std::string literal;
+    size_t min_before;
+    size_t max_before;
+};
+
+/// A regex compiled to a Thompson NFA.
+///
+/// Supported syntax: literals, `.` (any byte except '\n'), `[...]` and `[^...]` classes, escapes (`\d`, `\w`, `\s`,
+/// their negations, `\n`, `\t`, `\r`, and escaped punctuation), groups `(...)`, alternation `|`, and the quantifiers
+/// `*`, `+`, `?`, `{m}`, `{m,}`, `{m,n}`. Anchors are not supported.
+class Regex {
+public:
+    /// Length of matches of regexes containing `*`, `+` or `{m,}`.
+    static constexpr size_t UNBOUNDED = SIZE_MAX;
+
+    struct NfaState {
+        enum Kind {
+            Char,
+            Split,
+            Match,
+        } kind;
+        std::bitset<256> chars;
+        int out = -1;
+        int out1 = -1;
+    };
+
+private:
+    std::vector<NfaState> states;
+    int start = -1;
+    /// NFA of the reversed regex, which finds where a match starts from where it ends.
+    std::vector<NfaState> reverse_states;
+    int reverse_start = -1;
+    size_t min_len = 0;
+    size_t max_len = 0;
+    /// Any of these literals must appear in a match. Empty if no literal is required.
+    std::vector<RegexLiteral> literals;
+
+public:
+    /// Compile *expression*, throw an Exception on syntax errors.
+    explicit Regex(const char *expression);
+
+    auto get_states() const -> const std::vector<NfaState> & { return states; }
+
+    auto get_start() const -> int { return start; }
+
+    auto get_reverse_states() const -> const std::vector<NfaState> & { return reverse_states; }
+
+    auto get_reverse_start() const -> int { return reverse_start; }
+
+    auto min_length() const -> size_t { return min_len; }
+
+    /// The longest possible match, or UNBOUNDED.
+    auto max_length() const -> size_t { return max_len; }
+
+    auto required_literals() const -> const std::vector<RegexLiteral> & { return literals; }
+};
+
+/// Find the leftmost-longest, non-overlapping matches starting in text[0, owned_len), reading no further than
+/// text[text_len - 1]: like POSIX regexec, the scan takes the longest match at the leftmost position where the regex
+/// matches, and continues after it. If owned_len reaches text_len, a regex matching the empty string also gets the
+/// empty match at text_len. Candidate positions are located with `simd_search` on the required literals, and
+/// the automaton only runs around them.
+auto regex_search(const Regex &regex, const char *text, const size_t text_len, const size_t owned_len)
+-> std::vector<RegexMatch>;
+
+auto regex_search(const Regex &regex, const char *text, const size_t text_len) -> std::vector<RegexMatch>;
+
+/// Overlap needed between tasks, so that a task can read the longest match starting at its last position.
+auto regex_overlap(const Regex &regex, const size_t total_length) -> size_t;
+
+/// Concatenate the results of `regex_search` on *tasks*, given in positions of the whole text. Each task scanned from
+/// its own offset, while a match of the previous task may run past it; the matches near the start of each task are
+/// searched again until they agree with the sequential scan.
+auto regex_join(const Regex &regex, const char *text, const size_t total_length, const std::vector<Task> &tasks,
+                std::vector<std::vector<RegexMatch>> &&results) -> std::vector<RegexMatch>;
+
+#endif //PARALLEL_REGEX_SEARCH_H
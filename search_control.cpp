@@ -0,0 +1,80 @@
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <omp.h>
+#include "search_control.h"
+#include "kmp.h"
+#include "simd_search.h"
+#include "task.h"
+
+
+auto SearchControl::should_stop() const -> bool {
+    if (cancelled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    // Reading the clock is cheap compared with scanning a whole block, but skip it when there is no deadline.
+    auto time = deadline.load(std::memory_order_relaxed);
+    return time != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= time;
+}
+
+auto SearchControl::total_bytes_scanned() const -> size_t {
+    return std::accumulate(progress.begin(), progress.end(), size_t(0), [](size_t sum, const Counter &counter) {
+        return sum + counter.bytes.load(std::memory_order_relaxed);
+    });
+}
+
+auto search_cancellable(const uint8_t *p, size_t length, const char *pattern, unsigned int threads,
+                        SearchControl &control, SearchEngine engine) -> PartialResult {
+    assert(threads <= control.threads());
+
+    auto pattern_len = strlen(pattern);
+    auto tasks = split_tasks(length, pattern_len - 1, threads);
+
+    auto mid_result = std::vector<std::vector<size_t>>(threads);
+    // Each task covers the match positions [tasks[i].offset, covered_end[i]).
+    auto covered_end = std::vector<size_t>(threads);
+#pragma omp parallel num_threads(threads)
+    {
+        auto index = omp_get_thread_num();
+        auto begin = tasks[index].offset;
+        auto end = index + 1 < threads ? tasks[index + 1].offset : length;
+        auto &result = mid_result[index];
+
+        auto position = begin;
+        while (position < end && !control.should_stop()) {
+            // A block holds the matches starting in [position, block_end), and reads `pattern_len - 1` bytes more.
+            auto block_end = std::min(position + SEARCH_BLOCK_SIZE, end);
+            auto text = reinterpret_cast<const char *>(p + position);
+            auto text_len = std::min(block_end + pattern_len - 1, length) - position;
+
+            auto block_result = engine == SearchEngine::SIMD
+                                ? simd_search(text, text_len, pattern, pattern_len)
+                                : kmp_search(text, text_len, pattern, pattern_len);
+            for (auto r: block_result) {
+                result.push_back(position + r);
+            }
+
+            control.report(index, block_end - position);
+            position = block_end;
+        }
+        covered_end[index] = position;
+    }
+
+    PartialResult result;
+    for (unsigned int i = 0; i < threads; i++) {
+        result.matches.insert(result.matches.end(), mid_result[i].begin(), mid_result[i].end());
+
+        auto begin = tasks[i].offset;
+        if (covered_end[i] == begin) continue;
+        // Merge with the previous range if they are adjacent.
+        if (!result.covered.empty() && result.covered.back().second == begin) {
+            result.covered.back().second = covered_end[i];
+        } else {
+            result.covered.emplace_back(begin, covered_end[i]);
+        }
+    }
+    result.complete = length == 0
+                      || (result.covered.size() == 1 && result.covered[0] == std::pair<size_t, size_t>(0, length));
+    return result;
+}
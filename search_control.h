@@ -0,0 +1,81 @@
+#ifndef PARALLEL_SEARCH_CONTROL_H
+#define PARALLEL_SEARCH_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/// Shared state of a running search: it can be cancelled or bounded by a deadline, and its progress can be read
+/// from another thread. Workers only look at it between blocks of `SEARCH_BLOCK_SIZE` bytes.
+class SearchControl {
+private:
+    /// Keep counters of different threads in different cache lines.
+    struct alignas(64) Counter {
+        std::atomic<size_t> bytes{0};
+    };
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<std::chrono::steady_clock::time_point> deadline{std::chrono::steady_clock::time_point::max()};
+    std::vector<Counter> progress;
+
+public:
+    /// Allow at most *threads* workers.
+    explicit SearchControl(unsigned int threads = 1) : progress(threads) {}
+
+    auto cancel() -> void {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    auto set_deadline(std::chrono::steady_clock::time_point time) -> void {
+        deadline.store(time, std::memory_order_relaxed);
+    }
+
+    auto set_timeout(std::chrono::microseconds timeout) -> void {
+        set_deadline(std::chrono::steady_clock::now() + timeout);
+    }
+
+    /// Whether workers should stop before the next block.
+    auto should_stop() const -> bool;
+
+    auto threads() const -> unsigned int {
+        return progress.size();
+    }
+
+    /// Bytes scanned by the worker *thread* so far.
+    auto bytes_scanned(unsigned int thread) const -> size_t {
+        return progress[thread].bytes.load(std::memory_order_relaxed);
+    }
+
+    auto total_bytes_scanned() const -> size_t;
+
+    auto report(unsigned int thread, size_t bytes) -> void {
+        progress[thread].bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+};
+
+/// Matches of a search which may have been stopped early.
+struct PartialResult {
+    /// Offsets of matches found, in ascending order.
+    std::vector<size_t> matches;
+    /// Ranges [begin, end) in ascending order. Every match starting in these ranges is in *matches*, and no other.
+    std::vector<std::pair<size_t, size_t>> covered;
+    /// Whether the whole input is covered.
+    bool complete = false;
+};
+
+enum class SearchEngine {
+    KMP,
+    SIMD,
+};
+
+/// Workers check the SearchControl after each block of this size.
+constexpr size_t SEARCH_BLOCK_SIZE = 1024 * 1024;
+
+/// Search p[0, length) with *threads* OpenMP threads, stopping early when *control* asks to.
+auto search_cancellable(const uint8_t *p, size_t length, const char *pattern, unsigned int threads,
+                        SearchControl &control, SearchEngine engine = SearchEngine::SIMD) -> PartialResult;
+
+#endif //PARALLEL_SEARCH_CONTROL_H
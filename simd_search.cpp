@@ -8,7 +8,10 @@
 #include <cassert>
 #include <vector>
 #include <cstring>
+#include <algorithm>
+#include <numeric>
 #include <immintrin.h>
+#include "simd_search.h"
 
 
 namespace bits {
@@ -36,41 +39,219 @@ namespace bits {
 } // namespace bits
 
 
-auto simd_search(const char *text, const size_t text_len, const char *pattern,
-                 const size_t pattern_len) -> std::vector<size_t> {
-    std::vector<size_t> result;
+auto fixed_anchors(const size_t pattern_len) -> SimdAnchors {
+    SimdAnchors anchors;
+    if (pattern_len == 0) {
+        return anchors;
+    }
+
+    anchors.offsets[0] = 0;
+    anchors.offsets[1] = pattern_len - 1;
+    anchors.count = pattern_len == 1 ? 1 : 2;
+    return anchors;
+}
+
+auto text_byte_frequency() -> const ByteFrequency & {
+    // Rough per-mille frequencies of printable text. Bytes not listed are given weight 1, so that they are still
+    // considered rarer than anything that commonly appears in text.
+    static const ByteFrequency frequency = [] {
+        ByteFrequency table;
+        table.fill(1);
+
+        const char *lower = "etaoinsrhldcumfpgwybvkxjqz";
+        const uint32_t lower_weight[] = {95, 70, 62, 60, 55, 55, 50, 48, 40, 32, 30, 25, 22,
+                                         20, 18, 16, 15, 14, 13, 11, 8, 6, 2, 1, 1, 1};
+        for (size_t i = 0; i < 26; i++) {
+            table[static_cast<uint8_t>(lower[i])] = lower_weight[i] * 10;
+            table[static_cast<uint8_t>(lower[i] - 'a' + 'A')] = lower_weight[i] + 1;
+        }
+        for (auto c = '0'; c <= '9'; c++) {
+            table[static_cast<uint8_t>(c)] = 50;
+        }
+
+        table[' '] = 1700;
+        table['\n'] = 200;
+        table[','] = 100;
+        table['.'] = 100;
+        table['-'] = 30;
+        table[':'] = 20;
+        table['"'] = 20;
+        table['\''] = 20;
+        table['('] = 10;
+        table[')'] = 10;
+        table['_'] = 10;
+        table['/'] = 10;
+        table['='] = 10;
+        return table;
+    }();
+
+    return frequency;
+}
+
+auto sample_byte_frequency(const char *text, const size_t text_len, const size_t sample_len) -> ByteFrequency {
+    ByteFrequency frequency;
+    frequency.fill(0);
+
+    // Take up to 64 blocks evenly spaced over the input, instead of only reading the head of it.
+    const size_t block_count = 64;
+    const auto block_len = std::max<size_t>(1, std::min(sample_len, text_len) / block_count);
+    const auto stride = std::max<size_t>(block_len, text_len / block_count);
+
+    for (size_t offset = 0; offset + block_len <= text_len && offset / stride < block_count; offset += stride) {
+        auto p = reinterpret_cast<const uint8_t *>(text + offset);
+        for (size_t i = 0; i < block_len; i++) {
+            frequency[p[i]]++;
+        }
+    }
+    return frequency;
+}
+
+auto select_anchors(const char *pattern, const size_t pattern_len, const ByteFrequency &frequency,
+                    const size_t max_count) -> SimdAnchors {
+    assert(max_count >= 1 && max_count <= 3);
+
+    SimdAnchors anchors;
+    if (pattern_len == 0) {
+        return anchors;
+    }
+
+    // Rank positions by the frequency of the byte there. The first and the last position are listed ahead of the
+    // others, so that ties fall back to the classic first & last choice.
+    std::vector<size_t> positions(pattern_len);
+    std::iota(positions.begin(), positions.end(), 0);
+    if (pattern_len > 1) {
+        std::rotate(positions.begin() + 1, positions.end() - 1, positions.end());
+    }
+    auto byte_at = [&](size_t k) { return static_cast<uint8_t>(pattern[k]); };
+    std::stable_sort(positions.begin(), positions.end(), [&](size_t a, size_t b) {
+        return frequency[byte_at(a)] < frequency[byte_at(b)];
+    });
+
+    // The same byte at two positions carries little extra information, so take distinct bytes first.
+    std::vector<size_t> chosen;
+    for (auto k: positions) {
+        if (chosen.size() == max_count) break;
+        auto duplicated = std::any_of(chosen.begin(), chosen.end(), [&](size_t c) { return byte_at(c) == byte_at(k); });
+        if (!duplicated) chosen.push_back(k);
+    }
+    for (auto k: positions) {
+        if (chosen.size() == max_count) break;
+        if (std::find(chosen.begin(), chosen.end(), k) == chosen.end()) chosen.push_back(k);
+    }
+
+    std::sort(chosen.begin(), chosen.end());
+    std::copy(chosen.begin(), chosen.end(), anchors.offsets.begin());
+    anchors.count = chosen.size();
+    return anchors;
+}
 
-    // 向寄存器中填充 needle 的第一个字节
-    const __m256i first = _mm256_set1_epi8(pattern[0]);
-    // 向寄存器中填充 needle 的最后一个字节
-    const __m256i last = _mm256_set1_epi8(pattern[pattern_len - 1]);
 
-    for (size_t i = 0; i < text_len; i += 32) {
+/// Push the offsets (plus *base*) of all matches to *result*, which may be any container providing `push_back`.
+template<size_t N, ScanMode Mode, typename Output>
+static auto simd_search_anchored(const char *text, const size_t text_len, const char *pattern,
+                                 const size_t pattern_len, const SimdAnchors &anchors, const size_t base,
+                                 Output &result) -> void {
+    // 向寄存器中填充 needle 在各锚点处的字节
+    __m256i needle[N];
+    for (size_t k = 0; k < N; k++) {
+        needle[k] = _mm256_set1_epi8(pattern[anchors.offsets[k]]);
+    }
 
-        // 向寄存器中填充 s 的部分内容
-        const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+    // 主循环中的每个候选位置都可以完整地读取模式串，剩余部分由尾部的标量循环处理
+    size_t i = 0;
+    for (; i + 31 + pattern_len <= text_len; i += 32) {
 
-        // 向寄存器中填充 s 的部分内容，相对于上一行，本次填充的内容有所偏移
-        const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + pattern_len - 1));
+        // 每个 cache line 预取一次
+        if constexpr (Mode == ScanMode::Prefetch) {
+            if ((i & 63) == 0) _mm_prefetch(text + i + SIMD_PREFETCH_DISTANCE, _MM_HINT_T0);
+        } else if constexpr (Mode == ScanMode::Stream) {
+            if ((i & 63) == 0) _mm_prefetch(text + i + SIMD_PREFETCH_DISTANCE, _MM_HINT_NTA);
+        }
 
-        // 比较两组寄存器
-        const __m256i eq_first = _mm256_cmpeq_epi8(first, block_first);
-        const __m256i eq_last = _mm256_cmpeq_epi8(last, block_last);
+        // 向寄存器中填充 s 的部分内容，各锚点对应的内容有所偏移，并与 needle 比较
+        __m256i eq = _mm256_cmpeq_epi8(needle[0], _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(text + i + anchors.offsets[0])));
+        for (size_t k = 1; k < N; k++) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + anchors.offsets[k]));
+            eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(needle[k], block));
+        }
 
-        // 合并两个寄存器的比较结果
-        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+        uint32_t mask = _mm256_movemask_epi8(eq);
 
         while (mask != 0) {
             // 找到第一个值为 1 的 bit 的下标
             const auto bitpos = bits::get_first_bit_set(mask);
 
-            if (memcmp(text + i + bitpos + 1, pattern + 1, pattern_len - 2) == 0) {
-                result.push_back(i + bitpos);
+            if (memcmp(text + i + bitpos, pattern, pattern_len) == 0) {
+                result.push_back(base + i + bitpos);
             }
 
             mask = bits::clear_leftmost_set(mask);
         }
     }
 
+    for (; i + pattern_len <= text_len; i++) {
+        if (memcmp(text + i, pattern, pattern_len) == 0) {
+            result.push_back(base + i);
+        }
+    }
+}
+
+template<ScanMode Mode, typename Output>
+static auto simd_search_dispatch_anchors(const char *text, const size_t text_len, const char *pattern,
+                                         const size_t pattern_len, const SimdAnchors &anchors, const size_t base,
+                                         Output &result) -> void {
+    switch (anchors.count) {
+        case 1:
+            return simd_search_anchored<1, Mode>(text, text_len, pattern, pattern_len, anchors, base, result);
+        case 2:
+            return simd_search_anchored<2, Mode>(text, text_len, pattern, pattern_len, anchors, base, result);
+        case 3:
+            return simd_search_anchored<3, Mode>(text, text_len, pattern, pattern_len, anchors, base, result);
+        default:
+            assert(false && "anchor count must be 1, 2 or 3");
+    }
+}
+
+template<typename Output>
+static auto simd_search_dispatch(const char *text, const size_t text_len, const char *pattern,
+                                 const size_t pattern_len, const SimdAnchors &anchors, const size_t base,
+                                 const ScanMode mode, Output &result) -> void {
+    if (pattern_len == 0 || pattern_len > text_len) {
+        return;
+    }
+
+    switch (mode) {
+        case ScanMode::Normal:
+            return simd_search_dispatch_anchors<ScanMode::Normal>(text, text_len, pattern, pattern_len, anchors,
+                                                                  base, result);
+        case ScanMode::Prefetch:
+            return simd_search_dispatch_anchors<ScanMode::Prefetch>(text, text_len, pattern, pattern_len, anchors,
+                                                                    base, result);
+        case ScanMode::Stream:
+            return simd_search_dispatch_anchors<ScanMode::Stream>(text, text_len, pattern, pattern_len, anchors,
+                                                                  base, result);
+    }
+}
+
+auto simd_search(const char *text, const size_t text_len, const char *pattern,
+                 const size_t pattern_len) -> std::vector<size_t> {
+    return simd_search(text, text_len, pattern, pattern_len, fixed_anchors(pattern_len));
+}
+
+auto simd_search(const char *text, const size_t text_len, const char *pattern,
+                 const size_t pattern_len, const SimdAnchors &anchors, const ScanMode mode) -> std::vector<size_t> {
+    std::vector<size_t> result;
+    simd_search_dispatch(text, text_len, pattern, pattern_len, anchors, 0, mode, result);
     return result;
-}
\ No newline at end of file
+}
+
+auto simd_search(const char *text, const size_t text_len, const char *pattern, const size_t pattern_len,
+                 const SimdAnchors &anchors, const size_t base, VarintMatchList &result) -> void {
+    simd_search_dispatch(text, text_len, pattern, pattern_len, anchors, base, ScanMode::Normal, result);
+}
+
+auto simd_search(const char *text, const size_t text_len, const char *pattern, const size_t pattern_len,
+                 const SimdAnchors &anchors, const size_t base, MatchBitmap &result) -> void {
+    simd_search_dispatch(text, text_len, pattern, pattern_len, anchors, base, ScanMode::Normal, result);
+}
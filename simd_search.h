@@ -5,10 +5,60 @@
 #ifndef PARALLEL_SIMD_SEARCH_H
 #define PARALLEL_SIMD_SEARCH_H
 
+#include <array>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+#include "match_list.h"
+
+/// Byte-frequency table indexed by byte value, used to rank pattern positions by rarity.
+using ByteFrequency = std::array<uint32_t, 256>;
+
+/// Pattern positions compared by the SIMD filter before the full verification.
+struct SimdAnchors {
+    /// Offsets into the pattern, in ascending order. Only the first *count* entries are valid.
+    std::array<size_t, 3> offsets{};
+    size_t count = 0;
+};
+
+/// How the SIMD kernel brings the text into cache.
+enum class ScanMode {
+    /// Plain loads, relying on the hardware prefetcher.
+    Normal,
+    /// Software prefetch into all cache levels, `SIMD_PREFETCH_DISTANCE` bytes ahead.
+    Prefetch,
+    /// Non-temporal prefetch ahead, which keeps a one-pass scan from evicting other data from the cache.
+    Stream,
+};
+
+constexpr size_t SIMD_PREFETCH_DISTANCE = 1024;
+
+/// Anchor on the first and the last byte of the pattern, as the classic SIMD filter does.
+auto fixed_anchors(const size_t pattern_len) -> SimdAnchors;
+
+/// Built-in byte-frequency profile of English-like text (logs, source code, prose).
+auto text_byte_frequency() -> const ByteFrequency &;
+
+/// Build a byte histogram from evenly spaced samples of the input, reading at most *sample_len* bytes.
+auto sample_byte_frequency(const char *text, const size_t text_len, const size_t sample_len = 64 * 1024)
+-> ByteFrequency;
+
+/// Pick the *max_count* (2 or 3) rarest pattern positions according to *frequency*.
+auto select_anchors(const char *pattern, const size_t pattern_len, const ByteFrequency &frequency,
+                    const size_t max_count = 2) -> SimdAnchors;
 
 auto simd_search(const char *text, const size_t text_len, const char *pattern,
                  const size_t pattern_len) -> std::vector<size_t>;
 
+auto simd_search(const char *text, const size_t text_len, const char *pattern,
+                 const size_t pattern_len, const SimdAnchors &anchors,
+                 const ScanMode mode = ScanMode::Normal) -> std::vector<size_t>;
+
+/// Write matches of text[0, text_len) directly into a compact list, offset by *base* (usually the task offset).
+auto simd_search(const char *text, const size_t text_len, const char *pattern, const size_t pattern_len,
+                 const SimdAnchors &anchors, const size_t base, VarintMatchList &result) -> void;
+
+auto simd_search(const char *text, const size_t text_len, const char *pattern, const size_t pattern_len,
+                 const SimdAnchors &anchors, const size_t base, MatchBitmap &result) -> void;
+
 #endif //PARALLEL_SIMD_SEARCH_H
@@ -0,0 +1,21 @@
+#include <algorithm>
+#include "task.h"
+
+
+auto split_tasks(size_t total_length, size_t overlap, size_t count) -> std::vector<Task> {
+    // Assume that total size is 395, we split it into 4 tasks. And the length to the pattern is 5.
+    //  |__98__|__98__|__98__|__101__|
+    // tasks are: [0, 102), [98, 200), [196, 298), [294, 395)
+    // A task holds the matches starting in its own part only, since a match starting further needs bytes beyond it.
+    auto task_size = total_length / count;
+    std::vector<Task> tasks(count);
+
+    std::generate(tasks.begin(), tasks.end(), [&, i = size_t(0)]() mutable {
+        auto start = i * task_size;
+        auto end = i == count - 1 ? total_length : (i + 1) * task_size;
+        end = std::min(end + overlap, total_length);
+        i++;
+        return Task(start, end - start);
+    });
+    return tasks;
+}
@@ -0,0 +1,21 @@
+#ifndef PARALLEL_TASK_H
+#define PARALLEL_TASK_H
+
+#include <vector>
+#include <cstddef>
+
+/// A piece of the search region, assigned to one worker.
+struct Task {
+    size_t offset;
+    size_t size;
+
+    Task() = default;
+
+    Task(size_t offset, size_t size) : offset(offset), size(size) {}
+};
+
+/// Split [0, total_length) into *count* tasks. Each task extends *overlap* bytes (usually `pattern_len - 1`) into
+/// the next one, so that a match is found by exactly one task: the one where the match starts.
+auto split_tasks(size_t total_length, size_t overlap, size_t count) -> std::vector<Task>;
+
+#endif //PARALLEL_TASK_H
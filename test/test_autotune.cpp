@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "autotune.h"
+
+/// 8 threads, memory saturates at about 20 GB/s with 2 threads, like in the README.
+static auto make_profile() -> MachineProfile {
+    MachineProfile profile;
+    profile.hardware_threads = 8;
+    profile.bandwidth = {12, 20, 21, 21, 21, 21, 21, 21};
+    profile.simd_throughput = 30;
+    profile.kmp_throughput = 1.5;
+    profile.mode_throughput = {10, 12, 11};
+    return profile;
+}
+
+TEST(Autotune, TestBandwidthBound) {
+    auto config = tune(make_profile(), SearchEngine::SIMD, 2L * 1024 * 1024 * 1024);
+
+    ASSERT_EQ(config.threads, 2);
+    ASSERT_EQ(config.mode, ScanMode::Prefetch);
+    ASSERT_DOUBLE_EQ(config.predicted_throughput, 24);
+    ASSERT_GE(config.chunk_size * config.threads, 2L * 1024 * 1024 * 1024);
+}
+
+TEST(Autotune, TestScanModeMargin) {
+    // A few percent is within the noise of the measurement, keep the plain loads.
+    auto profile = make_profile();
+    profile.mode_throughput = {20, 20.8, 19};
+    auto config = tune(profile, SearchEngine::SIMD, 2L * 1024 * 1024 * 1024);
+
+    ASSERT_EQ(config.mode, ScanMode::Normal);
+    ASSERT_DOUBLE_EQ(config.predicted_throughput, 20);
+}
+
+TEST(Autotune, TestComputeBound) {
+    auto size = 2L * 1024 * 1024 * 1024;
+    auto config = tune(make_profile(), SearchEngine::KMP, size);
+
+    ASSERT_EQ(config.threads, 8);
+    ASSERT_DOUBLE_EQ(config.predicted_throughput, 12);
+    // Smaller chunks than threads, to balance the load.
+    ASSERT_LT(config.chunk_size * config.threads, size);
+}
+
+TEST(Autotune, TestSmallInput) {
+    auto config = tune(make_profile(), SearchEngine::KMP, 3 * 1024 * 1024);
+
+    ASSERT_EQ(config.threads, 3);
+    ASSERT_EQ(config.mode, ScanMode::Normal);
+
+    config = tune(make_profile(), SearchEngine::SIMD, 1000);
+    ASSERT_EQ(config.threads, 1);
+}
+
+TEST(Autotune, TestProfileFile) {
+    auto path = (std::filesystem::temp_directory_path() / "test_autotune_profile.txt").string();
+    auto profile = make_profile();
+
+    ASSERT_TRUE(save_profile(path.c_str(), profile));
+    auto loaded = load_profile(path.c_str());
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(loaded->hardware_threads, profile.hardware_threads);
+    ASSERT_EQ(loaded->bandwidth, profile.bandwidth);
+    ASSERT_EQ(loaded->mode_throughput, profile.mode_throughput);
+    ASSERT_FALSE(load_profile("/nonexistent/test_autotune_profile.txt").has_value());
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <filesystem>
+#include "file_mapper.h"
+
+class FileMapperTest : public ::testing::Test {
+protected:
+    std::string filename = (std::filesystem::temp_directory_path() / "test_file_mapper.bin").string();
+    std::string content;
+
+    void SetUp() override {
+        for (auto i = 0; i < 10000; i++) {
+            content += static_cast<char>('a' + i % 26);
+        }
+        std::ofstream(filename, std::ios::binary) << content;
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(filename);
+    }
+};
+
+TEST_F(FileMapperTest, TestWholeFile) {
+    FileMapper mapper(filename.c_str());
+    mapper.load();
+
+    ASSERT_EQ(mapper.get_size(), content.size());
+    ASSERT_EQ(mapper.get_file_size(), content.size());
+    ASSERT_EQ(memcmp(mapper.get_start(), content.data(), content.size()), 0);
+}
+
+TEST_F(FileMapperTest, TestRange) {
+    FileMapper mapper(filename.c_str());
+    // The offset is not aligned to the page size, and the range goes beyond the end of the file.
+    mapper.load(5000, 6000);
+
+    ASSERT_EQ(mapper.get_size(), 5000);
+    ASSERT_EQ(memcmp(mapper.get_start(), content.data() + 5000, 5000), 0);
+
+    mapper.load(10000, 100);
+    ASSERT_EQ(mapper.get_size(), 0);
+}
+
+TEST_F(FileMapperTest, TestMissingFile) {
+    FileMapper mapper("/nonexistent/test_file_mapper.bin");
+
+    ASSERT_THROW(mapper.load(), Exception);
+}
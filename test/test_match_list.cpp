@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "match_list.h"
+#include "simd_search.h"
+#include "task.h"
+
+TEST(MatchList, TestVarintRoundTrip) {
+    auto expected = std::vector<size_t>{0, 0, 1, 127, 128, 16384, 1ul << 40, (1ul << 40) + 1};
+
+    auto list = VarintMatchList();
+    for (auto offset: expected) {
+        list.push_back(offset);
+    }
+
+    ASSERT_EQ(list.size(), expected.size());
+    ASSERT_EQ(list.to_vector(), expected);
+}
+
+TEST(MatchList, TestVarintAppend) {
+    auto first = VarintMatchList(0);
+    first.push_back(3);
+    first.push_back(90);
+    auto empty = VarintMatchList(100);
+    auto second = VarintMatchList(200);
+    second.push_back(200);
+    second.push_back(1000);
+
+    auto list = VarintMatchList();
+    list.append(std::move(first));
+    list.append(std::move(empty));
+    list.append(std::move(second));
+
+    auto expected = std::vector<size_t>{3, 90, 200, 1000};
+    ASSERT_EQ(list.size(), expected.size());
+    ASSERT_EQ(list.to_vector(), expected);
+    // Deltas are relative to the segment base, so each of them fits in a byte or two.
+    ASSERT_EQ(list.encoded_size(), 5);
+}
+
+TEST(MatchList, TestBitmap) {
+    auto first = MatchBitmap(0, 70);
+    first.push_back(0);
+    first.push_back(69);
+    auto second = MatchBitmap(70, 200);
+    second.push_back(70);
+    second.push_back(134);
+    second.push_back(269);
+
+    auto bitmap = MatchBitmap();
+    bitmap.append(MatchBitmap(0, 0));
+    bitmap.append(std::move(first));
+    bitmap.append(std::move(second));
+
+    auto expected = std::vector<size_t>{0, 69, 70, 134, 269};
+    ASSERT_EQ(bitmap.size(), expected.size());
+    ASSERT_EQ(bitmap.to_vector(), expected);
+    ASSERT_TRUE(MatchBitmap().begin() == MatchBitmap().end());
+}
+
+TEST(MatchList, TestSplitTasks) {
+    auto tasks = split_tasks(395, 4, 4);
+
+    ASSERT_EQ(tasks.size(), 4);
+    ASSERT_EQ(tasks[0].offset, 0);
+    ASSERT_EQ(tasks[0].size, 102);
+    ASSERT_EQ(tasks[1].offset, 98);
+    ASSERT_EQ(tasks[3].offset, 294);
+    ASSERT_EQ(tasks[3].size, 101);
+}
+
+TEST(MatchList, TestDenseSearchByTasks) {
+    auto text = std::string();
+    for (auto i = 0; i < 10000; i++) {
+        text += "ACGTAAAGATTACA"[i * i % 14];
+    }
+    const char *pattern = "AA";
+    auto expected = simd_search(text.data(), text.size(), pattern, 2);
+    auto anchors = fixed_anchors(2);
+
+    auto list = VarintMatchList();
+    auto bitmap = MatchBitmap();
+    for (auto [offset, size]: split_tasks(text.size(), 1, 7)) {
+        auto part_list = VarintMatchList(offset);
+        simd_search(text.data() + offset, size, pattern, 2, anchors, offset, part_list);
+        list.append(std::move(part_list));
+
+        auto part_bitmap = MatchBitmap(offset, size - 1);
+        simd_search(text.data() + offset, size, pattern, 2, anchors, offset, part_bitmap);
+        bitmap.append(std::move(part_bitmap));
+    }
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(list.to_vector(), expected);
+    ASSERT_EQ(bitmap.to_vector(), expected);
+}
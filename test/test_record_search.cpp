@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "record_search.h"
+#include "simd_search.h"
+
+TEST(Records, TestBoundaries) {
+    // Records are separated by '\n', which is not part of any record.
+    std::string buffer = "PATTERN\nxxPATT\nERNxx\nPATTERNPATTERN\n\nPATTERN";
+    std::vector<size_t> offsets = {0, 8, 15, 21, 36, 37};
+    std::vector<size_t> lengths = {7, 6, 5, 14, 0, 7};
+    auto pattern = "PATTERN";
+
+    for (auto threads: {1u, 2u, 4u}) {
+        auto result = search_records(buffer.data(), offsets.data(), lengths.data(), offsets.size(), pattern, 7,
+                                     threads);
+        std::vector<RecordMatch> expected = {{0, 0}, {3, 0}, {3, 7}, {5, 0}};
+        ASSERT_EQ(result, expected);
+    }
+}
+
+TEST(Records, TestManyRecords) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> length_dis(20, 200);
+    std::uniform_int_distribution<int> byte_dis('a', 'd');
+
+    std::string buffer;
+    std::vector<size_t> offsets, lengths;
+    for (auto i = 0; i < 20000; i++) {
+        offsets.push_back(buffer.size());
+        lengths.push_back(length_dis(gen));
+        for (size_t k = 0; k < lengths.back(); k++) {
+            buffer += static_cast<char>(byte_dis(gen));
+        }
+        buffer += '\n';
+    }
+
+    auto pattern = "abcd";
+    std::vector<RecordMatch> expected;
+    for (size_t i = 0; i < offsets.size(); i++) {
+        for (auto offset: simd_search(buffer.data() + offsets[i], lengths[i], pattern, 4)) {
+            expected.push_back({i, offset});
+        }
+    }
+
+    ASSERT_FALSE(expected.empty());
+    for (auto threads: {1u, 3u}) {
+        auto result = search_records(buffer.data(), offsets.data(), lengths.data(), offsets.size(), pattern, 4,
+                                     threads);
+        ASSERT_EQ(result, expected);
+    }
+}
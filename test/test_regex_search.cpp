@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <regex>
+#include "regex_search.h"
+#include "exception.h"
+#include "task.h"
+
+/// Scan with POSIX (leftmost-longest) std::regex.
+static auto reference_search(const char *expression, const std::string &text) -> std::vector<RegexMatch> {
+    std::regex re(expression, std::regex::extended);
+    std::vector<RegexMatch> result;
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), re); it != std::sregex_iterator(); it++) {
+        auto start = static_cast<size_t>(it->position(0));
+        result.push_back({start, start + it->length(0)});
+    }
+    return result;
+}
+
+static auto random_text(size_t size, const char *alphabet) -> std::string {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> dis(0, strlen(alphabet) - 1);
+    std::string text;
+    for (size_t i = 0; i < size; i++) {
+        text += alphabet[dis(gen)];
+    }
+    return text;
+}
+
+TEST(Regex, TestLiteralPrefilter) {
+    Regex regex("ERROR [0-9]+ timeout");
+    ASSERT_EQ(regex.min_length(), 15);
+    ASSERT_EQ(regex.max_length(), Regex::UNBOUNDED);
+    ASSERT_EQ(regex.required_literals().size(), 1);
+    ASSERT_EQ(regex.required_literals()[0].literal, "ERROR ");
+
+    std::string text = "ok\nERROR 42 timeout\nERROR x timeout\nERROR 7 timeout ERROR 1234 timeou";
+    auto result = regex_search(regex, text.data(), text.size());
+    std::vector<RegexMatch> expected = {{3, 19}, {36, 51}};
+
+    ASSERT_EQ(result, expected);
+}
+
+TEST(Regex, TestAlternation) {
+    Regex regex("foo[0-9]|ba+r");
+    ASSERT_EQ(regex.required_literals().size(), 2);
+
+    std::string text = "foo1 baar br foox bar";
+    auto result = regex_search(regex, text.data(), text.size());
+    std::vector<RegexMatch> expected = {{0, 4}, {5, 9}, {18, 21}};
+    ASSERT_EQ(result, expected);
+}
+
+TEST(Regex, TestAgainstReference) {
+    auto text = random_text(3000, "ab01 .-");
+    const char *expressions[] = {
+            "ab", "a(b|0)+1", "(a|b)[01]{2,3}", "[^ab]+\\.", "b?a{1,2}0", "[0-9] [ab]", "(ab|a)(b1|01)*",
+            "[a-]{3}", "0.0", "x|ab", "(ab)?0", "a*", "(ab|0)?", "[01]*b?", "(a|b1)*.?",
+    };
+    for (auto expression: expressions) {
+        Regex regex(expression);
+        ASSERT_EQ(regex_search(regex, text.data(), text.size()), reference_search(expression, text)) << expression;
+    }
+}
+
+TEST(Regex, TestEmptyMatches) {
+    // Including the empty match at the end of the text.
+    std::pair<const char *, std::string> cases[] = {{"a*", "b"}, {"x?", "ab"}, {"a*", "aab"}, {"(ab)*", ""}};
+    for (const auto &[expression, text]: cases) {
+        Regex regex(expression);
+        ASSERT_EQ(regex_search(regex, text.data(), text.size()), reference_search(expression, text)) << expression;
+    }
+    std::vector<RegexMatch> expected = {{0, 0}};
+    ASSERT_EQ(regex_search(Regex(""), "", 0), expected);
+}
+
+TEST(Regex, TestEscapes) {
+    Regex regex("\\d+\\s\\w\\.[^\\d]");
+
+    std::string text = "12 a.b 3\tZ.. 4 _.5";
+    auto result = regex_search(regex, text.data(), text.size());
+    std::vector<RegexMatch> expected = {{0, 6}, {7, 12}};
+    ASSERT_EQ(result, expected);
+}
+
+TEST(Regex, TestTasks) {
+    auto text = random_text(10000, "ab01");
+    for (auto expression: {"ab{1,3}0", "a[01]+b", "(a|b)(a|b)", "[ab]+0?", "[a1]*"}) {
+        Regex regex(expression);
+        auto expected = regex_search(regex, text.data(), text.size());
+
+        auto tasks = split_tasks(text.size(), regex_overlap(regex, text.size()), 7);
+        std::vector<std::vector<RegexMatch>> results;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            auto [offset, size] = tasks[i];
+            auto owned = (i + 1 < tasks.size() ? tasks[i + 1].offset : text.size()) - offset;
+            auto &result = results.emplace_back();
+            for (auto [start, end]: regex_search(regex, text.data() + offset, size, owned)) {
+                result.push_back({start + offset, end + offset});
+            }
+        }
+        auto result = regex_join(regex, text.data(), text.size(), tasks, std::move(results));
+        ASSERT_EQ(result, expected) << expression;
+    }
+}
+
+TEST(Regex, TestLinearTime) {
+    // Every position could start a match, but none completes: each must be rejected without being retried.
+    std::string text(4 * 1024 * 1024, 'a');
+    ASSERT_TRUE(regex_search(Regex("[a-z]+Q"), text.data(), text.size()).empty());
+    ASSERT_TRUE(regex_search(Regex("[a-z]+[0-9]"), text.data(), text.size()).empty());
+
+    text.back() = 'Q';
+    auto result = regex_search(Regex("[a-z]+Q"), text.data(), text.size());
+    std::vector<RegexMatch> expected = {{0, text.size()}};
+    ASSERT_EQ(result, expected);
+}
+
+TEST(Regex, TestCacheFlush) {
+    // The automaton tracks the last 13 bytes, which needs more states than the cache holds.
+    auto text = random_text(20000, "ab");
+    Regex regex("a[ab]{12}b");
+
+    std::vector<RegexMatch> expected;
+    for (size_t i = 0; i + 14 <= text.size();) {
+        if (text[i] == 'a' && text[i + 13] == 'b') {
+            expected.push_back({i, i + 14});
+            i += 14;
+        } else {
+            i++;
+        }
+    }
+    ASSERT_EQ(regex_search(regex, text.data(), text.size()), expected);
+}
+
+TEST(Regex, TestSyntaxError) {
+    ASSERT_THROW(Regex("(ab"), Exception);
+    ASSERT_THROW(Regex("ab)"), Exception);
+    ASSERT_THROW(Regex("[ab"), Exception);
+    ASSERT_THROW(Regex("*a"), Exception);
+    ASSERT_THROW(Regex("^a"), Exception);
+    ASSERT_THROW(Regex("a{3,2}"), Exception);
+    ASSERT_THROW(Regex("\\q"), Exception);
+}
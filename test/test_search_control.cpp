@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "search_control.h"
+#include "simd_search.h"
+
+static auto make_text(size_t size, const char *pattern, size_t step) -> std::vector<uint8_t> {
+    auto text = std::vector<uint8_t>(size, 'x');
+    auto pattern_length = strlen(pattern);
+    for (size_t offset = 3; offset + pattern_length <= size; offset += step) {
+        memcpy(text.data() + offset, pattern, pattern_length);
+    }
+    return text;
+}
+
+TEST(SearchControl, TestComplete) {
+    auto pattern = "PATTERN";
+    auto text = make_text(5 * SEARCH_BLOCK_SIZE + 123, pattern, 100000);
+    auto expected = simd_search(reinterpret_cast<const char *>(text.data()), text.size(), pattern, strlen(pattern));
+
+    for (auto engine: {SearchEngine::SIMD, SearchEngine::KMP}) {
+        SearchControl control(3);
+        auto result = search_cancellable(text.data(), text.size(), pattern, 3, control, engine);
+
+        ASSERT_TRUE(result.complete);
+        ASSERT_EQ(result.covered.size(), 1);
+        ASSERT_EQ(result.matches, expected);
+        ASSERT_EQ(control.total_bytes_scanned(), text.size());
+    }
+}
+
+TEST(SearchControl, TestExpiredDeadline) {
+    auto pattern = "PATTERN";
+    auto text = make_text(SEARCH_BLOCK_SIZE, pattern, 1000);
+
+    SearchControl control(2);
+    control.set_deadline(std::chrono::steady_clock::now());
+    auto result = search_cancellable(text.data(), text.size(), pattern, 2, control);
+
+    ASSERT_FALSE(result.complete);
+    ASSERT_TRUE(result.covered.empty());
+    ASSERT_TRUE(result.matches.empty());
+    ASSERT_EQ(control.total_bytes_scanned(), 0);
+}
+
+TEST(SearchControl, TestCancelFromAnotherThread) {
+    auto pattern = "PATTERN";
+    auto text = make_text(256 * SEARCH_BLOCK_SIZE, pattern, 4096);
+
+    SearchControl control(1);
+    auto watcher = std::thread([&] {
+        while (control.bytes_scanned(0) < 2 * SEARCH_BLOCK_SIZE) {
+            std::this_thread::yield();
+        }
+        control.cancel();
+    });
+    auto result = search_cancellable(text.data(), text.size(), pattern, 1, control);
+    watcher.join();
+
+    ASSERT_FALSE(result.complete);
+    ASSERT_EQ(result.covered.size(), 1);
+    auto [begin, end] = result.covered[0];
+    ASSERT_EQ(begin, 0);
+    ASSERT_LT(end, text.size());
+    ASSERT_EQ(end % SEARCH_BLOCK_SIZE, 0);
+
+    // Exactly the matches starting in the covered range are reported.
+    auto expected = simd_search(reinterpret_cast<const char *>(text.data()), end + strlen(pattern) - 1, pattern,
+                                strlen(pattern));
+    ASSERT_EQ(result.matches, expected);
+}
@@ -40,4 +40,80 @@ TEST(SIMD, Test2) {
 
     ASSERT_EQ(result.size(), expected.size());
     ASSERT_EQ(result, expected);
-}
\ No newline at end of file
+}
+
+TEST(SIMD, TestPatternAtTail) {
+    auto buffer = std::vector<char>(100, 'x');
+    auto pattern = "PATTERN";
+    auto pattern_length = strlen(pattern);
+    memcpy(buffer.data() + 100 - pattern_length, pattern, pattern_length);
+
+    auto result = simd_search(buffer.data(), buffer.size(), pattern, pattern_length);
+    std::vector<size_t> expected = {100 - pattern_length};
+
+    ASSERT_EQ(result, expected);
+}
+
+TEST(SIMD, TestSingleByte) {
+    const char *text = "abcabcabcabcabcabcabcabcabcabcabcabcabcabc";
+    auto result = simd_search(text, strlen(text), "c", 1);
+
+    ASSERT_EQ(result.size(), 14);
+    ASSERT_EQ(result.front(), 2);
+}
+
+TEST(SIMD, TestSelectAnchors) {
+    const char *pattern = " jukebox ";
+    auto anchors = select_anchors(pattern, strlen(pattern), text_byte_frequency());
+
+    // 'j' and 'x' are the rarest bytes in text, while the spaces at both ends are the most common.
+    ASSERT_EQ(anchors.count, 2);
+    ASSERT_EQ(anchors.offsets[0], 1);
+    ASSERT_EQ(anchors.offsets[1], 7);
+
+    // With no information about the input, fall back to the first and the last byte.
+    ByteFrequency uniform;
+    uniform.fill(1);
+    anchors = select_anchors("jukebox", 7, uniform);
+    ASSERT_EQ(anchors.count, 2);
+    ASSERT_EQ(anchors.offsets[0], 0);
+    ASSERT_EQ(anchors.offsets[1], 6);
+}
+
+TEST(SIMD, TestSampledAnchors) {
+    auto buffer = std::vector<char>(1 << 20, 0);
+    const char *pattern = "\0\0AB\0\0";
+    auto pattern_length = 6;
+
+    auto expected = std::vector<size_t>{10, 1000, 10000, 100000, 1000000};
+    for (auto offset: expected) {
+        memcpy(buffer.data() + offset, pattern, pattern_length);
+    }
+
+    auto frequency = sample_byte_frequency(buffer.data(), buffer.size());
+    auto anchors = select_anchors(pattern, pattern_length, frequency, 3);
+    ASSERT_EQ(anchors.count, 3);
+    ASSERT_EQ(anchors.offsets[0], 0);
+    ASSERT_EQ(anchors.offsets[1], 2);
+    ASSERT_EQ(anchors.offsets[2], 3);
+
+    auto result = simd_search(buffer.data(), buffer.size(), pattern, pattern_length, anchors);
+    ASSERT_EQ(result, expected);
+    ASSERT_EQ(simd_search(buffer.data(), buffer.size(), pattern, pattern_length), expected);
+}
+
+TEST(SIMD, TestScanModes) {
+    auto buffer = std::vector<char>(1 << 20, 'x');
+    auto pattern = "ABABCABAB";
+    auto pattern_length = strlen(pattern);
+
+    auto expected = std::vector<size_t>{10, 1000, 10000, 100000, (1 << 20) - pattern_length};
+    for (auto offset: expected) {
+        memcpy(buffer.data() + offset, pattern, pattern_length);
+    }
+
+    auto anchors = fixed_anchors(pattern_length);
+    for (auto mode: {ScanMode::Normal, ScanMode::Prefetch, ScanMode::Stream}) {
+        ASSERT_EQ(simd_search(buffer.data(), buffer.size(), pattern, pattern_length, anchors, mode), expected);
+    }
+}